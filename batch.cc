@@ -0,0 +1,246 @@
+#include "batch.h"
+#include "quadrant.h"
+
+#include <iostream>
+#include <sstream>
+#include <iomanip>
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+using namespace std;
+
+int BATCH_QUEUE_CAPACITY = 1024;
+
+
+BoardCache::BoardCache(size_t max_boards) {
+	this->max_boards = max_boards;
+	this->num_requests = 0;
+}
+
+shared_ptr<const Board> BoardCache::getBoard(const array<int, 4>& layout) {
+	lock_guard<mutex> lock(this->boards_mutex);
+	this->num_requests++;
+	auto entry = this->boards.find(layout);
+	if (entry != this->boards.end()) {
+		entry->second.last_used = this->num_requests;
+		return entry->second.board;
+	}
+
+	if (this->max_boards > 0 && this->boards.size() >= this->max_boards) {
+		auto oldest = this->boards.begin();
+		for (auto other = this->boards.begin(); other != this->boards.end(); ++other) {
+			if (other->second.last_used < oldest->second.last_used) {
+				oldest = other;
+			}
+		}
+		this->boards.erase(oldest);
+	}
+	// built under the lock, so two threads never compile the same layout
+	shared_ptr<Board> board = make_shared<Board>();
+	buildBoard(board.get(), layout[0], layout[1], layout[2], layout[3]);
+	this->boards[layout] = {board, this->num_requests};
+	return board;
+}
+
+
+struct BatchResult {
+	long sequence; // position of the puzzle in the input, results are written back in this order
+	string line;
+};
+
+
+static bool parseCell(istream& fields, int* cell) {
+	int row, col;
+	if (!(fields >> row >> col) || row < 0 || row >= COMPILED_DIMENSION || col < 0 || col >= COMPILED_DIMENSION) {
+		return false;
+	}
+	*cell = cellOf(row, col);
+	return true;
+}
+
+bool parseBatchPuzzle(const string& line, int line_num, BatchPuzzle* puzzle) {
+	ASSERT(puzzle != NULL, "cannot parse into a null puzzle");
+	puzzle->line_num = line_num;
+	puzzle->error.clear();
+	istringstream fields(line);
+
+	for (int i = 0; i < 4; i++) {
+		if (!(fields >> puzzle->layout[i]) || puzzle->layout[i] < 1 || puzzle->layout[i] > NUM_QUADRANTS) {
+			puzzle->error = "bad quadrant layout";
+			return false;
+		}
+	}
+
+	puzzle->robot_positions = CompactArrangement();
+	for (int robot = 0; robot < NUM_ROBOTS; robot++) {
+		int cell;
+		if (!parseCell(fields, &cell)) {
+			puzzle->error = "bad " + all_colors[robot] + " robot position";
+			return false;
+		}
+		bool above_diag = fields.peek() != '-';
+		if (!above_diag) {
+			fields.get();
+		}
+		for (int other = 0; other < robot; other++) {
+			if (puzzle->robot_positions.getCell(other) == cell) {
+				puzzle->error = "two robots on one cell";
+				return false;
+			}
+		}
+		puzzle->robot_positions.setRobot(robot, cell, above_diag);
+	}
+
+	if (!parseCell(fields, &puzzle->dest_cell)) {
+		puzzle->error = "bad target position";
+		return false;
+	}
+
+	string dest_color;
+	fields >> dest_color;
+	puzzle->dest_robot = find(all_colors.begin(), all_colors.end(), dest_color) - all_colors.begin();
+	if (puzzle->dest_robot >= NUM_ROBOTS) {
+		puzzle->error = "bad target color";
+		return false;
+	}
+
+	string extra;
+	if (fields >> extra) {
+		puzzle->error = "trailing fields";
+		return false;
+	}
+	return true;
+}
+
+string formatBatchPuzzle(const BatchPuzzle& puzzle) {
+	ostringstream line;
+	line << puzzle.layout[0] << " " << puzzle.layout[1] << " " << puzzle.layout[2] << " " << puzzle.layout[3] << " ";
+	for (int robot = 0; robot < NUM_ROBOTS; robot++) {
+		int cell = puzzle.robot_positions.getCell(robot);
+		line << " " << rowOf(cell) << " " << colOf(cell) << (puzzle.robot_positions.getAboveDiag(robot) ? "" : "-");
+	}
+	line << "  " << rowOf(puzzle.dest_cell) << " " << colOf(puzzle.dest_cell) << " " << all_colors[puzzle.dest_robot];
+	return line.str();
+}
+
+
+static BatchResult solvePuzzle(long sequence, const BatchPuzzle& puzzle, BoardCache* boards, SolutionCache* cache,
+	SearchAlgorithm algorithm, int max_depth) {
+
+	ostringstream line;
+	line << puzzle.line_num << " ";
+	if (!puzzle.error.empty()) {
+		line << "error " << puzzle.error;
+		return {sequence, line.str()};
+	}
+
+	auto start = chrono::steady_clock::now();
+	shared_ptr<const Board> board_ref = boards->getBoard(puzzle.layout);
+	const Board& board = *board_ref;
+	Position dest(rowOf(puzzle.dest_cell), colOf(puzzle.dest_cell));
+	CacheKey key = {board.getFingerprint(), board.normalized(puzzle.robot_positions).key(), puzzle.dest_cell,
+		puzzle.dest_robot};
+	vector<vector<Move>> solutions(1);
+	int solution_length;
+	if (cache == NULL || !cache->lookup(key, max_depth, &solution_length, &solutions[0])) {
+		solutions.clear();
+		solution_length = solveRicochetBoard(board, puzzle.robot_positions.toRobotArrangement(), dest,
+			all_colors[puzzle.dest_robot], &solutions, 1, algorithm, max_depth);
+		if (cache != NULL) {
+			cache->store(key, max_depth, solution_length, solutions.empty() ? vector<Move>() : solutions[0]);
+		}
+	}
+	double millis = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+
+	line << solution_length << " " << fixed << setprecision(3) << millis;
+	if (!solutions.empty()) {
+		for (size_t i = 0; i < solutions[0].size(); i++) {
+			line << " " << getColor(solutions[0][i]) << "," << getDirection(solutions[0][i]);
+		}
+	}
+	return {sequence, line.str()};
+}
+
+
+int solveBatch(istream& in, ostream& out, int num_threads, SearchAlgorithm algorithm, int max_depth,
+	SolutionCache* cache) {
+
+	if (num_threads <= 0) {
+		num_threads = max(1u, thread::hardware_concurrency());
+	}
+
+	BoardCache boards;
+	BoundedQueue<pair<long, BatchPuzzle>> parsed(BATCH_QUEUE_CAPACITY);
+	BoundedQueue<BatchResult> solved(BATCH_QUEUE_CAPACITY);
+
+	// results are written in input order, so a slow puzzle holds back the ones after it. the parser waits
+	// while too many puzzles are in flight, which keeps the reorder buffer below bounded as well
+	mutex window_mutex;
+	condition_variable window_open;
+	long num_written = 0;
+	long max_in_flight = 2 * BATCH_QUEUE_CAPACITY + num_threads;
+
+	int num_errors = 0;
+	thread parser([&] {
+		string line;
+		int line_num = 0;
+		long sequence = 0;
+		while (getline(in, line)) {
+			line_num++;
+			size_t first = line.find_first_not_of(" \t\r");
+			if (first == string::npos || line[first] == '#') {
+				continue;
+			}
+
+			BatchPuzzle puzzle;
+			if (!parseBatchPuzzle(line, line_num, &puzzle)) {
+				num_errors++;
+			}
+			{
+				unique_lock<mutex> lock(window_mutex);
+				window_open.wait(lock, [&] { return sequence - num_written < max_in_flight; });
+			}
+			parsed.push(make_pair(sequence, puzzle));
+			sequence++;
+		}
+		parsed.close();
+	});
+
+	vector<thread> solvers;
+	for (int i = 0; i < num_threads; i++) {
+		solvers.push_back(thread([&] {
+			pair<long, BatchPuzzle> job;
+			while (parsed.pop(&job)) {
+				solved.push(solvePuzzle(job.first, job.second, &boards, cache, algorithm, max_depth));
+			}
+		}));
+	}
+
+	thread closer([&] {
+		for (thread& solver : solvers) {
+			solver.join();
+		}
+		solved.close();
+	});
+
+	map<long, string> pending;
+	BatchResult result;
+	while (solved.pop(&result)) {
+		pending[result.sequence] = result.line;
+		while (!pending.empty() && pending.begin()->first == num_written) {
+			out << pending.begin()->second << "\n";
+			pending.erase(pending.begin());
+			lock_guard<mutex> lock(window_mutex);
+			num_written++;
+			window_open.notify_one();
+		}
+	}
+	out.flush();
+
+	parser.join();
+	closer.join();
+	return num_errors;
+}
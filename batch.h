@@ -0,0 +1,117 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+#include "robots.h"
+#include "board.h"
+#include "solver.h"
+#include "cache.h"
+
+#include <array>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <istream>
+#include <ostream>
+
+using namespace std;
+
+// puzzles parsed ahead of the solvers, and solved puzzles waiting to be written, are capped at this many
+extern int BATCH_QUEUE_CAPACITY;
+
+// fifo shared between pipeline stages. push blocks while full, pop blocks while empty
+// and returns false once the queue is closed and drained
+template <typename T>
+class BoundedQueue {
+
+	deque<T> items;
+	size_t capacity;
+	bool closed;
+	mutex items_mutex;
+	condition_variable not_full;
+	condition_variable not_empty;
+
+public:
+
+	BoundedQueue(size_t capacity) : capacity(capacity), closed(false) {}
+
+	void push(T item) {
+		unique_lock<mutex> lock(this->items_mutex);
+		this->not_full.wait(lock, [this] { return this->items.size() < this->capacity; });
+		this->items.push_back(move(item));
+		this->not_empty.notify_one();
+	}
+
+	bool pop(T* item) {
+		unique_lock<mutex> lock(this->items_mutex);
+		this->not_empty.wait(lock, [this] { return !this->items.empty() || this->closed; });
+		if (this->items.empty()) {
+			return false;
+		}
+		*item = move(this->items.front());
+		this->items.pop_front();
+		this->not_full.notify_one();
+		return true;
+	}
+
+	void close() {
+		lock_guard<mutex> lock(this->items_mutex);
+		this->closed = true;
+		this->not_empty.notify_all();
+	}
+};
+
+// compiled boards by quadrant layout, built the first time a layout is asked for. safe to share between threads.
+// with a max_boards, the least recently asked for board is dropped to make room for a new one, and lives on
+// until the last caller holding it lets go
+class BoardCache {
+
+	struct Entry {
+		shared_ptr<const Board> board;
+		long last_used;
+	};
+
+	map<array<int, 4>, Entry> boards;
+	size_t max_boards; // 0 for no limit
+	long num_requests;
+	mutex boards_mutex;
+
+public:
+
+	BoardCache(size_t max_boards=0);
+
+	shared_ptr<const Board> getBoard(const array<int, 4>& layout);
+};
+
+// one puzzle per line, blank lines and lines starting with # are skipped:
+//   q1 q2 q3 q4  yellow_row yellow_col red_row red_col green_row green_col blue_row blue_col  dest_row dest_col color
+// where q1 .. q4 are quadrant numbers laid out as in buildBoard. a robot col may end in - for a robot below
+// the diag of its cell, robots are above it otherwise (as Position has it), which only matters on diag cells
+struct BatchPuzzle {
+	int line_num;
+	array<int, 4> layout;
+	CompactArrangement robot_positions;
+	int dest_cell;
+	int dest_robot;
+	string error; // set instead of the fields above when the line does not parse
+};
+
+// returns false and sets puzzle->error if the line is malformed
+bool parseBatchPuzzle(const string& line, int line_num, BatchPuzzle* puzzle);
+
+// the line parseBatchPuzzle reads back as this puzzle
+string formatBatchPuzzle(const BatchPuzzle& puzzle);
+
+// solves every puzzle read from in on num_threads solver threads (0 picks one per hardware thread),
+// with one thread parsing ahead and the calling thread writing results. writes one line per puzzle, in input order:
+//   line_num length millis color,direction color,direction ...
+// with length -1 when no solution shorter than max_depth exists, or
+//   line_num error message
+// for malformed lines. boards are built and compiled once per quadrant layout and shared across puzzles.
+// with a cache, puzzles found there are answered from it and new solutions are added to it.
+// returns the number of puzzles that did not parse
+int solveBatch(istream& in, ostream& out, int num_threads=0, SearchAlgorithm algorithm=ITERATIVE_DEEPENING,
+	int max_depth=DEFAULT_MAX_DEPTH, SolutionCache* cache=NULL);
+
+#endif
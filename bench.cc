@@ -0,0 +1,425 @@
+#include "board.h"
+#include "solver.h"
+#include "quadrant.h"
+#include "visited.h"
+#include "batch.h"
+#include "successors.h"
+#include "parallel.h"
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <random>
+#include <thread>
+
+using namespace std;
+
+// ricochet-bench [--json file] [--baseline file] [--threshold percent] [--filter substring]
+// microbenchmarks for the move generator, encoding and visited table, then end to end solves of a fixed
+// corpus with each search algorithm. prints a table to stderr and json to stdout (or --json).
+// with a baseline from an earlier run, exits 1 if any benchmark got more than threshold percent slower
+
+// microbenchmarks repeat until they have run at least this long
+static const double MIN_BENCH_SECONDS = 0.5;
+static const int NUM_BENCH_ARRANGEMENTS = 4096;
+
+
+// every allocation in the process goes through here so benchmarks can count them
+static atomic<long> num_allocations(0);
+
+void* operator new(size_t size) {
+	num_allocations++;
+	void* p = malloc(size == 0 ? 1 : size);
+	if (p == NULL) {
+		throw bad_alloc();
+	}
+	return p;
+}
+
+void operator delete(void* p) noexcept {
+	free(p);
+}
+
+
+// a puzzle in the batch format, with its known optimal length
+struct CorpusPuzzle {
+	const char* line;
+	int solution_length;
+};
+
+// two puzzles for each length from 3 to 11 and one each for 2 and 12, over three layouts
+static const CorpusPuzzle BENCH_CORPUS[] = {
+	{"1 3 5 7 6 7 0 10 6 5 8 0 0 6 red", 2},
+	{"1 4 5 8 0 9 5 11 7 3 9 8 11 15 green", 3},
+	{"1 3 5 7 10 6 0 7 2 3 1 12 9 15 blue", 3},
+	{"1 4 5 8 9 6 5 9 8 12 9 9 6 8 red", 4},
+	{"2 4 6 8 15 2 5 6 5 2 5 4 14 2 red", 4},
+	{"1 4 5 8 1 11 12 5 15 5 15 10 5 6 yellow", 5},
+	{"1 4 5 8 10 14 8 0 8 4 5 10 0 15 green", 5},
+	{"2 4 6 8 12 5 9 1 8 15 9 7 12 1 green", 6},
+	{"1 3 5 7 7 9 12 14 1 6 10 3 15 0 yellow", 6},
+	{"1 4 5 8 5 0 9 1 14 11 9 9 4 15 blue", 7},
+	{"1 3 5 7 12 9 12 5 10 13 3 11 7 15 blue", 7},
+	{"1 4 5 8 3 12 9 11 8 15 2 1 5 14 blue", 8},
+	{"1 4 5 8 1 8 8 11 15 4 11 7 5 15 green", 8},
+	{"1 4 5 8 12 11 10 4 13 14 4 13 6 11 blue", 9},
+	{"2 4 6 8 1 11 15 2 9 3 2 4 14 15 blue", 9},
+	{"1 4 5 8 14 0 6 5 13 0 3 1 8 15 red", 10},
+	{"1 4 5 8 9 1 14 5 15 0 15 15 4 7 red", 10},
+	{"1 3 5 7 4 11 6 13 12 8 6 10 14 3 yellow", 11},
+	{"2 4 6 8 6 11 4 10 8 6 12 15 13 13 blue", 11},
+	{"1 4 5 8 3 13 11 4 0 12 15 14 2 7 red", 12},
+};
+
+
+struct BenchResult {
+	string name;
+	long ops;
+	double seconds;
+	long allocations;
+	long peak_rss_kb; // -1 if unknown
+	long nodes; // search nodes expanded, 0 for benchmarks that do not search
+
+	double nsPerOp() const { return 1e9 * this->seconds / this->ops; }
+};
+
+
+static double now() {
+	return chrono::duration<double>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// peak rss since the last reset, from /proc/self/status
+static long peakRssKb() {
+	ifstream status("/proc/self/status");
+	string line;
+	while (getline(status, line)) {
+		if (line.compare(0, 6, "VmHWM:") == 0) {
+			return atol(line.c_str() + 6);
+		}
+	}
+	return -1;
+}
+
+static void resetPeakRss() {
+	ofstream clear_refs("/proc/self/clear_refs");
+	clear_refs << "5";
+}
+
+// runs round (which performs ops_per_round operations and returns the nodes it expanded) until
+// min_seconds have passed
+template <typename Round>
+static BenchResult runBenchmark(const string& name, long ops_per_round, double min_seconds, Round round) {
+	resetPeakRss();
+	BenchResult result = {name, 0, 0, 0, -1, 0};
+	long allocations_before = num_allocations;
+	double start = now();
+	do {
+		result.nodes += round();
+		result.ops += ops_per_round;
+		result.seconds = now() - start;
+	} while (result.seconds < min_seconds);
+	result.allocations = num_allocations - allocations_before;
+	result.peak_rss_kb = peakRssKb();
+	return result;
+}
+
+// stops the compiler from dropping work whose result is otherwise unused
+static volatile long sink;
+
+
+static vector<CompactArrangement> benchArrangements() {
+	mt19937 rng(42);
+	vector<CompactArrangement> arrangements;
+	while ((int) arrangements.size() < NUM_BENCH_ARRANGEMENTS) {
+		CompactArrangement robot_positions;
+		bool distinct = true;
+		for (int robot = 0; robot < NUM_ROBOTS; robot++) {
+			int cell = rng() % NUM_CELLS;
+			for (int other = 0; other < robot; other++) {
+				distinct = distinct && robot_positions.getCell(other) != cell;
+			}
+			robot_positions.setRobot(robot, cell, true);
+		}
+		if (distinct) {
+			arrangements.push_back(robot_positions);
+		}
+	}
+	return arrangements;
+}
+
+static void microBenchmarks(const string& filter, vector<BenchResult>* results) {
+	Board board;
+	buildBoard(&board, 1, 3, 5, 7);
+	vector<CompactArrangement> arrangements = benchArrangements();
+	vector<RobotArrangement> full_arrangements;
+	for (const CompactArrangement& robot_positions : arrangements) {
+		full_arrangements.push_back(robot_positions.toRobotArrangement());
+	}
+
+	if (string("makeMove/compact").find(filter) != string::npos) {
+		results->push_back(runBenchmark("makeMove/compact", NUM_BENCH_ARRANGEMENTS * NUM_MOVES, MIN_BENCH_SECONDS, [&] {
+			long moved = 0;
+			for (const CompactArrangement& robot_positions : arrangements) {
+				for (Move move : all_moves) {
+					CompactArrangement new_robot_positions = robot_positions;
+					moved += board.makeMove(move, &new_robot_positions);
+				}
+			}
+			sink = moved;
+			return 0L;
+		}));
+	}
+
+	// all sixteen moves of an arrangement per call, with the AVX2 kernel when the cpu has it and with the scalar one
+	for (bool simd : {true, false}) {
+		string name = simd ? "generateChildren" : "generateChildren/scalar";
+		if (name.find(filter) == string::npos || (simd && !usingSimdSuccessors())) {
+			continue;
+		}
+		SIMD_SUCCESSORS = simd;
+		results->push_back(runBenchmark(name, NUM_BENCH_ARRANGEMENTS * NUM_MOVES, MIN_BENCH_SECONDS, [&] {
+			long moved = 0;
+			CompactArrangement children[NUM_MOVES];
+			Move child_moves[NUM_MOVES];
+			for (const CompactArrangement& robot_positions : arrangements) {
+				moved += board.generateChildren(robot_positions, children, child_moves);
+			}
+			sink = moved;
+			return 0L;
+		}));
+		SIMD_SUCCESSORS = true;
+	}
+
+	if (string("makeMove/robot_arrangement").find(filter) != string::npos) {
+		results->push_back(runBenchmark("makeMove/robot_arrangement", NUM_BENCH_ARRANGEMENTS * NUM_MOVES,
+			MIN_BENCH_SECONDS, [&] {
+			long moved = 0;
+			for (const RobotArrangement& robot_positions : full_arrangements) {
+				for (Move move : all_moves) {
+					RobotArrangement new_robot_positions(robot_positions);
+					moved += board.makeMove(move, &new_robot_positions);
+				}
+			}
+			sink = moved;
+			return 0L;
+		}));
+	}
+
+	if (string("encode").find(filter) != string::npos) {
+		results->push_back(runBenchmark("encode", NUM_BENCH_ARRANGEMENTS, MIN_BENCH_SECONDS, [&] {
+			RobotArrangementEncoding keys = 0;
+			for (const RobotArrangement& robot_positions : full_arrangements) {
+				keys ^= encode(robot_positions);
+			}
+			sink = keys;
+			return 0L;
+		}));
+	}
+
+	// the first round records every arrangement, the rest measure the probe that turns revisits away
+	if (string("worthExpanding").find(filter) != string::npos) {
+		VisitedTable visited(board);
+		results->push_back(runBenchmark("worthExpanding", NUM_BENCH_ARRANGEMENTS, MIN_BENCH_SECONDS, [&] {
+			long expanded = 0;
+			for (const CompactArrangement& robot_positions : arrangements) {
+				expanded += worthExpanding(robot_positions, &visited, 3, 8);
+			}
+			sink = expanded;
+			return 0L;
+		}));
+	}
+}
+
+
+// names of the parallel bfs runs, one per thread count
+static const string PARALLEL_BENCH_PREFIX = "corpus/parallel_breadth_first/threads_";
+
+// solves the whole corpus once with the given algorithm, on freshly built boards so cached distance
+// maps from an earlier run do not count. returns the nodes expanded
+static long solveCorpus(SearchAlgorithm algorithm) {
+	long nodes = 0;
+	for (const CorpusPuzzle& corpus_puzzle : BENCH_CORPUS) {
+		BatchPuzzle puzzle;
+		bool parsed = parseBatchPuzzle(corpus_puzzle.line, 0, &puzzle);
+		ASSERT(parsed, "bad corpus puzzle " << corpus_puzzle.line);
+		Board board;
+		buildBoard(&board, puzzle.layout[0], puzzle.layout[1], puzzle.layout[2], puzzle.layout[3]);
+		Position dest(rowOf(puzzle.dest_cell), colOf(puzzle.dest_cell));
+		RobotArrangement robot_positions = puzzle.robot_positions.toRobotArrangement();
+		const string& dest_color = all_colors[puzzle.dest_robot];
+
+		vector<vector<Move>> solutions;
+		SolverStats stats;
+		int solution_length = solveRicochetBoard(board, robot_positions, dest, dest_color, &solutions, 1, algorithm,
+			DEFAULT_MAX_DEPTH, &stats);
+		nodes += stats.getNodesExpanded();
+		ASSERT(solution_length == corpus_puzzle.solution_length, "corpus puzzle " << corpus_puzzle.line
+			<< " solved in " << solution_length << " moves, expected " << corpus_puzzle.solution_length);
+	}
+	return nodes;
+}
+
+static void corpusBenchmarks(const string& filter, vector<BenchResult>* results) {
+	const pair<string, SearchAlgorithm> algorithms[] = {
+		{"corpus/iterative_deepening", ITERATIVE_DEEPENING},
+		{"corpus/breadth_first", BREADTH_FIRST},
+		{"corpus/ida_star", IDA_STAR},
+	};
+	long num_puzzles = sizeof(BENCH_CORPUS) / sizeof(BENCH_CORPUS[0]);
+	for (const pair<string, SearchAlgorithm>& algorithm : algorithms) {
+		if (algorithm.first.find(filter) != string::npos) {
+			// one pass is long enough to time
+			results->push_back(runBenchmark(algorithm.first, num_puzzles, 0, [&] {
+				return solveCorpus(algorithm.second);
+			}));
+		}
+	}
+
+	// the parallel bfs on 1, 2, 4 .. threads, up to one per hardware thread
+	int hardware_threads = max(1u, thread::hardware_concurrency());
+	for (int num_threads = 1; ; num_threads = min(2 * num_threads, hardware_threads)) {
+		string name = PARALLEL_BENCH_PREFIX + to_string(num_threads);
+		if (name.find(filter) != string::npos) {
+			PARALLEL_SEARCH_THREADS = num_threads;
+			results->push_back(runBenchmark(name, num_puzzles, 0, [&] {
+				return solveCorpus(PARALLEL_BREADTH_FIRST);
+			}));
+			PARALLEL_SEARCH_THREADS = 0;
+		}
+		if (num_threads == hardware_threads) {
+			break;
+		}
+	}
+}
+
+// speedup of each parallel bfs run over the one thread run, when both ran
+static void printParallelScaling(const vector<BenchResult>& results) {
+	double one_thread_seconds = 0;
+	for (const BenchResult& result : results) {
+		if (result.name == PARALLEL_BENCH_PREFIX + "1") {
+			one_thread_seconds = result.seconds;
+		}
+	}
+	for (const BenchResult& result : results) {
+		int num_threads = result.name.compare(0, PARALLEL_BENCH_PREFIX.size(), PARALLEL_BENCH_PREFIX) == 0 ?
+			atoi(result.name.c_str() + PARALLEL_BENCH_PREFIX.size()) : 0;
+		if (one_thread_seconds > 0 && num_threads > 1) {
+			cerr << "parallel_breadth_first on " << num_threads << " threads: " << setprecision(2)
+				<< one_thread_seconds / result.seconds << "x the one thread speed" << endl;
+		}
+	}
+}
+
+
+static string toJson(const vector<BenchResult>& results) {
+	ostringstream json;
+	json << "{\n";
+#ifdef __OPTIMIZE__
+	json << "  \"optimized\": true,\n";
+#else
+	json << "  \"optimized\": false,\n";
+#endif
+	json << "  \"compiler\": \"" << __VERSION__ << "\",\n";
+	json << "  \"benchmarks\": [\n";
+	for (size_t i = 0; i < results.size(); i++) {
+		const BenchResult& result = results[i];
+		json << "    {\"name\": \"" << result.name << "\", \"ops\": " << result.ops
+			<< fixed << setprecision(6) << ", \"seconds\": " << result.seconds
+			<< setprecision(2) << ", \"ns_per_op\": " << result.nsPerOp()
+			<< setprecision(3) << ", \"allocs_per_op\": " << double(result.allocations) / result.ops;
+		if (result.nodes > 0) {
+			json << ", \"nodes\": " << result.nodes << ", \"nodes_per_sec\": " << long(result.nodes / result.seconds);
+		}
+		json << ", \"peak_rss_kb\": " << result.peak_rss_kb << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+	}
+	json << "  ]\n}\n";
+	return json.str();
+}
+
+// ns_per_op by benchmark name from an earlier run's json. reads just the fields it needs
+static map<string, double> readBaseline(const string& path) {
+	ifstream file(path);
+	ASSERT(file, "cannot open baseline " << path);
+	stringstream contents;
+	contents << file.rdbuf();
+	string json = contents.str();
+
+	map<string, double> ns_per_op;
+	const string NAME = "\"name\": \"";
+	const string NS_PER_OP = "\"ns_per_op\": ";
+	for (size_t pos = json.find(NAME); pos != string::npos; pos = json.find(NAME, pos)) {
+		pos += NAME.size();
+		string name = json.substr(pos, json.find('"', pos) - pos);
+		size_t value = json.find(NS_PER_OP, pos);
+		if (value != string::npos) {
+			ns_per_op[name] = atof(json.c_str() + value + NS_PER_OP.size());
+		}
+	}
+	return ns_per_op;
+}
+
+
+int main(int argc, char* argv[]) {
+	string json_path;
+	string baseline_path;
+	string filter;
+	double threshold = 10;
+	for (int i = 1; i + 1 < argc; i += 2) {
+		string flag = argv[i];
+		if (flag == "--json") {
+			json_path = argv[i + 1];
+		} else if (flag == "--baseline") {
+			baseline_path = argv[i + 1];
+		} else if (flag == "--threshold") {
+			threshold = atof(argv[i + 1]);
+		} else if (flag == "--filter") {
+			filter = argv[i + 1];
+		} else {
+			ASSERT(false, "unknown flag " << flag);
+		}
+	}
+	vector<BenchResult> results;
+	microBenchmarks(filter, &results);
+	corpusBenchmarks(filter, &results);
+
+	map<string, double> baseline;
+	if (!baseline_path.empty()) {
+		baseline = readBaseline(baseline_path);
+	}
+
+	bool regressed = false;
+	cerr << left << setw(42) << "benchmark" << right << setw(14) << "ns/op" << setw(12) << "allocs/op"
+		<< setw(14) << "nodes/s" << setw(12) << "peak kB" << setw(12) << "baseline" << endl;
+	for (const BenchResult& result : results) {
+		cerr << left << setw(42) << result.name << right << fixed << setprecision(1) << setw(14) << result.nsPerOp()
+			<< setprecision(2) << setw(12) << double(result.allocations) / result.ops
+			<< setw(14) << (result.nodes > 0 ? to_string(long(result.nodes / result.seconds)) : "-")
+			<< setw(12) << result.peak_rss_kb;
+		auto baseline_result = baseline.find(result.name);
+		if (baseline_result != baseline.end()) {
+			double change = 100 * (result.nsPerOp() / baseline_result->second - 1);
+			cerr << setw(11) << showpos << setprecision(1) << change << "%" << noshowpos;
+			if (change > threshold) {
+				cerr << "  REGRESSION";
+				regressed = true;
+			}
+		}
+		cerr << endl;
+	}
+
+	printParallelScaling(results);
+
+	if (json_path.empty()) {
+		cout << toJson(results);
+	} else {
+		ofstream json(json_path);
+		json << toJson(results);
+	}
+	return regressed ? 1 : 0;
+}
@@ -1,7 +1,10 @@
 #include "board.h"
 #include "solver.h"
 #include "quadrant.h"
+#include "successors.h"
 #include <iostream>
+#include <algorithm>
+#include <cstring>
 
 using namespace std;
 
@@ -62,11 +65,17 @@ const string& DiagBarrier::getColor() const {
 	return this->color;
 }
 
+int DiagBarrier::getRobot() const {
+	return this->robot;
+}
+
 
 
 
 Board::Board(int board_dimension) {
 
+	this->compiled = false;
+
 	for (int row = 0; row < board_dimension; row++) {
 		// set edge of board barriers
 		vector<int> rb_indices;
@@ -97,25 +106,27 @@ bool Board::solve(const RobotArrangement& robots, const Position& dest, const st
 
 bool Board::hasRowBarrier(int row, int col) const {
 	ASSERT(0 <= row && row < BOARD_DIMENSION, "Row " << row << " cannot have a row barrier");
-	vector<int> rb_indices = this->row_barriers[row];
+	const vector<int>& rb_indices = this->row_barriers[row];
 	return find(rb_indices.begin(), rb_indices.end(), col) != rb_indices.end();
 
 }
 
 bool Board::hasColBarrier(int col, int row) const {
-	vector<int> cb_indices = this->col_barriers[col];
+	const vector<int>& cb_indices = this->col_barriers[col];
 	return find(cb_indices.begin(), cb_indices.end(), row) != cb_indices.end();
 }
 
 bool Board::hasDiagBarrier(int row, int col) const {
-	vector<pair<int, DiagBarrier>> diag_indices = this->diag_barriers[row];
-	for (pair<int, DiagBarrier> diag : this->diag_barriers[row]) {
+	return this->findDiagBarrier(row, col) != NULL;
+}
+
+const DiagBarrier* Board::findDiagBarrier(int row, int col) const {
+	for (const pair<int, DiagBarrier>& diag : this->diag_barriers[row]) {
 		if (diag.first == col) {
-			return true;
+			return &diag.second;
 		}
 	}
-	
-	return false;
+	return NULL;
 }
 
 DiagBarrier Board::getDiagBarrier(int row, int col) const {
@@ -133,12 +144,22 @@ void Board::setRowBarrier(int row, int col) {
 	ASSERT(this->row_barriers.size() >= row + 1, "row barriers not long enough to set in row " << row);
 	ASSERT(0 <= col and col <= BOARD_DIMENSION, "col " << col << " out of range");
 	insertInOrder(&(this->row_barriers[row]), col);
+	this->compiled = false;
 }
 
 void Board::setColBarrier(int col, int row) {
 	ASSERT(this->col_barriers.size() >= col + 1, "col barriers not long enough to set in col " << col);
 	ASSERT(0 <= row and row <= BOARD_DIMENSION, "row " << row << " out of range");
 	insertInOrder(&(this->col_barriers[col]), row);
+	this->compiled = false;
+}
+
+void Board::setBarriers(const vector<vector<int>>& row_barriers, const vector<vector<int>>& col_barriers) {
+	ASSERT(row_barriers.size() == this->row_barriers.size(), "expected " << this->row_barriers.size() << " rows");
+	ASSERT(col_barriers.size() == this->col_barriers.size(), "expected " << this->col_barriers.size() << " cols");
+	this->row_barriers = row_barriers;
+	this->col_barriers = col_barriers;
+	this->compiled = false;
 }
 
 void Board::setDiagBarrier(int row, int col, const string& color, bool is_forward) {
@@ -146,6 +167,291 @@ void Board::setDiagBarrier(int row, int col, const string& color, bool is_forwar
 	ASSERT(0 <= col and col < BOARD_DIMENSION, "col " << col << " out of range");
 	DiagBarrier db(color, is_forward);
 	insertDiagInOrder(&(this->diag_barriers[row]), make_pair(col, db));
+	this->compiled = false;
+}
+
+
+void Board::compile() {
+	ASSERT(BOARD_DIMENSION == COMPILED_DIMENSION, "compiled tables need a " << COMPILED_DIMENSION << " board");
+
+	int last = COMPILED_DIMENSION - 1;
+	int steps[NUM_DIRECTIONS];
+	steps[NORTH] = -COMPILED_DIMENSION;
+	steps[SOUTH] = COMPILED_DIMENSION;
+	steps[EAST] = 1;
+	steps[WEST] = -1;
+
+	// wall bitboards, in the same terms the slow moves check barriers
+	for (int direction = 0; direction < NUM_DIRECTIONS; direction++) {
+		this->walls[direction] = Bitboard();
+		this->slow_rays[direction] = Bitboard();
+	}
+	this->diag_cells = Bitboard();
+	for (int robot = 0; robot < NUM_ROBOTS_MAX; robot++) {
+		this->colored_diag_cells[robot] = Bitboard();
+	}
+	memset(this->line_walls, 0, sizeof(this->line_walls));
+
+	// fnv-1a over every wall bit and diag of each cell
+	const uint64_t FNV_PRIME = 0x100000001b3;
+	this->fingerprint = 0xcbf29ce484222325;
+
+	for (int row = 0; row < COMPILED_DIMENSION; row++) {
+		for (int col = 0; col < COMPILED_DIMENSION; col++) {
+			int cell = cellOf(row, col);
+			if (row == 0 || this->hasColBarrier(col, row)) this->walls[NORTH].set(cell);
+			if (row == last || this->hasColBarrier(col, row + 1)) this->walls[SOUTH].set(cell);
+			if (col == last || this->hasRowBarrier(row, col + 1)) this->walls[EAST].set(cell);
+			if (col == 0 || this->hasRowBarrier(row, col)) this->walls[WEST].set(cell);
+			if (this->hasDiagBarrier(row, col)) {
+				this->diag_cells.set(cell);
+				this->colored_diag_cells[getRobotIndex(this->getDiagBarrier(row, col).getColor())].set(cell);
+			}
+
+			int cell_bits = 0;
+			for (int direction = 0; direction < NUM_DIRECTIONS; direction++) {
+				cell_bits |= this->walls[direction].test(cell) << direction;
+				this->line_walls[direction][lineOf(cell, direction)] |= this->walls[direction].test(cell) << indexOnLine(cell, direction);
+			}
+			if (this->hasDiagBarrier(row, col)) {
+				DiagBarrier db = this->getDiagBarrier(row, col);
+				cell_bits |= (1 + getRobotIndex(db.getColor())) << 4 | db.isForward() << 7;
+			}
+			this->fingerprint = (this->fingerprint ^ cell_bits) * FNV_PRIME;
+		}
+	}
+
+	for (int dest_robot = 0; dest_robot < NUM_ROBOTS; dest_robot++) {
+		int helpers = 0;
+		int num_helpers = 0;
+		for (int robot = 0; robot < NUM_ROBOTS; robot++) {
+			if (robot != dest_robot && !this->colored_diag_cells[robot].any()) {
+				helpers |= 1 << robot;
+				num_helpers++;
+			}
+		}
+		this->interchangeable_robots[dest_robot] = num_helpers >= 2 ? helpers : 0;
+	}
+
+	// slide a lone robot from every cell until it reaches a wall
+	fill(this->slow_directions, this->slow_directions + NUM_CELLS, 0);
+	for (int direction = 0; direction < NUM_DIRECTIONS; direction++) {
+		for (int start = 0; start < NUM_CELLS; start++) {
+			Bitboard ray;
+			bool touches_diag = this->diag_cells.test(start);
+			int cell = start;
+			while (!this->walls[direction].test(cell)) {
+				cell += steps[direction];
+				ray.set(cell);
+				touches_diag = touches_diag || this->diag_cells.test(cell);
+			}
+
+			this->rays[direction][start] = ray;
+			this->stop_cells[direction][start] = cell;
+			if (touches_diag) {
+				this->slow_rays[direction].set(start);
+				this->slow_directions[start] |= 1 << direction;
+			}
+		}
+	}
+
+	// every slow ray's path, as the move kernel runs it with the other robots off the board
+	this->diag_path_index.assign(NUM_CELLS * NUM_DIRECTIONS * NUM_ROBOTS_MAX * 2, -1);
+	this->diag_paths.clear();
+	this->diag_path_steps.clear();
+	for (int start = 0; start < NUM_CELLS; start++) {
+		for (int direction = 0; direction < NUM_DIRECTIONS; direction++) {
+			if (!this->slow_rays[direction].test(start)) {
+				continue;
+			}
+			for (int robot = 0; robot < NUM_ROBOTS_MAX; robot++) {
+				for (int above_diag = 0; above_diag < 2; above_diag++) {
+					int rows[NUM_ROBOTS_MAX];
+					int cols[NUM_ROBOTS_MAX];
+					fill(rows, rows + NUM_ROBOTS_MAX, -1);
+					fill(cols, cols + NUM_ROBOTS_MAX, -1);
+					rows[robot] = rowOf(start);
+					cols[robot] = colOf(start);
+					bool path_above_diag = above_diag;
+					vector<uint16_t> steps;
+					this->slideRobot(direction, robot, rows, cols, &path_above_diag, &steps);
+
+					DiagPath path;
+					path.first_step = this->diag_path_steps.size();
+					path.num_steps = steps.size();
+					for (uint16_t step : steps) {
+						path.cells.set(step >> 1);
+					}
+					this->diag_path_steps.insert(this->diag_path_steps.end(), steps.begin(), steps.end());
+					this->diag_path_index[((start * NUM_DIRECTIONS + direction) * NUM_ROBOTS_MAX + robot) * 2 + above_diag] =
+						this->diag_paths.size();
+					this->diag_paths.push_back(path);
+				}
+			}
+		}
+	}
+
+	// the distance maps depend on the walls just compiled
+	lock_guard<mutex> lock(this->distance_maps_mutex);
+	for (int table = 0; table <= NUM_ROBOTS_MAX; table++) {
+		this->reach_tables[table].clear();
+	}
+	this->distance_maps.clear();
+
+	this->compiled = true;
+}
+
+bool Board::isCompiled() const {
+	return this->compiled;
+}
+
+Bitboard Board::getDiagCells() const {
+	if (this->compiled) {
+		return this->diag_cells;
+	}
+
+	// straight from the barriers, for the visited tables of searches on boards built with the setters
+	Bitboard diag_cells;
+	for (int row = 0; row < (int) this->diag_barriers.size() && row < COMPILED_DIMENSION; row++) {
+		for (const pair<int, DiagBarrier>& diag : this->diag_barriers[row]) {
+			if (diag.first < COMPILED_DIMENSION) {
+				diag_cells.set(cellOf(row, diag.first));
+			}
+		}
+	}
+	return diag_cells;
+}
+
+bool Board::arrivalSide(int cell, int direction, int robot, bool* above_diag) const {
+	ASSERT(above_diag != NULL, "cannot write the side into a null bit");
+	int row = rowOf(cell) + (direction == NORTH) - (direction == SOUTH);
+	int col = colOf(cell) + (direction == WEST) - (direction == EAST);
+	if (row < 0 || row >= BOARD_DIMENSION || col < 0 || col >= BOARD_DIMENSION || this->hasDiagBarrier(row, col)) {
+		return false;
+	}
+
+	// a lone robot from the neighbor, its second step is the diag cell unless a wall is in between
+	int rows[NUM_ROBOTS_MAX];
+	int cols[NUM_ROBOTS_MAX];
+	fill(rows, rows + NUM_ROBOTS_MAX, -1);
+	fill(cols, cols + NUM_ROBOTS_MAX, -1);
+	rows[robot] = row;
+	cols[robot] = col;
+	bool path_above_diag = false;
+	vector<uint16_t> steps;
+	this->slideRobot(direction, robot, rows, cols, &path_above_diag, &steps);
+	if (steps.size() < 2 || (steps[1] >> 1) != cell) {
+		return false;
+	}
+	*above_diag = steps[1] & 1;
+	return true;
+}
+
+CompactArrangement Board::normalized(const CompactArrangement& robot_positions) const {
+	Bitboard diag_cells = this->getDiagCells();
+	CompactArrangement result = robot_positions;
+	for (int robot = 0; robot < NUM_ROBOTS; robot++) {
+		int cell = result.getCell(robot);
+		result.setRobot(robot, cell, result.getAboveDiag(robot) && diag_cells.test(cell));
+	}
+	return result;
+}
+
+uint64_t Board::getFingerprint() const {
+	ASSERT(this->compiled, "the fingerprint is only known once the board is compiled");
+	return this->fingerprint;
+}
+
+int Board::getInterchangeableRobots(int dest_robot) const {
+	// an uncompiled board has not worked out its diag colors, so treats every robot as distinct
+	return this->compiled ? this->interchangeable_robots[dest_robot] : 0;
+}
+
+// robots without a diag of their color all move alike when alone, so they share one table
+int Board::reachTableIndex(int robot) const {
+	return this->colored_diag_cells[robot].any() ? robot : NUM_ROBOTS_MAX;
+}
+
+// every cell the robot can stop on in one move from each cell, for some placement of the other robots.
+// caller holds distance_maps_mutex
+const vector<Bitboard>& Board::getReachTable(int robot) const {
+	vector<Bitboard>& reach = this->reach_tables[this->reachTableIndex(robot)];
+	if (!reach.empty()) {
+		return reach;
+	}
+
+	reach.resize(NUM_CELLS);
+	for (int cell = 0; cell < NUM_CELLS; cell++) {
+		for (int direction = 0; direction < NUM_DIRECTIONS; direction++) {
+			if (!this->slow_rays[direction].test(cell)) {
+				// can be stopped on any cell of a plain ray
+				reach[cell] |= this->rays[direction][cell];
+				continue;
+			}
+
+			// a diag ray may bend, but a blocker can still stop it on any step of its path, from either side of a diag
+			for (int above_diag = 0; above_diag < 2; above_diag++) {
+				const DiagPath& path = this->getDiagPath(cell, direction, robot, above_diag);
+				for (int step = 0; step < path.num_steps; step++) {
+					int stop = this->diag_path_steps[path.first_step + step] >> 1;
+					if (stop != cell) {
+						reach[cell].set(stop);
+					}
+				}
+			}
+		}
+	}
+
+	return reach;
+}
+
+const vector<uint8_t>& Board::getDistanceMap(int dest_cell, int robot) const {
+	ASSERT(this->compiled, "distance maps need a compiled board");
+	ASSERT(0 <= dest_cell && dest_cell < NUM_CELLS, "dest cell " << dest_cell << " out of range");
+
+	lock_guard<mutex> lock(this->distance_maps_mutex);
+	int key = this->reachTableIndex(robot) * NUM_CELLS + dest_cell;
+	auto cached = this->distance_maps.find(key);
+	if (cached != this->distance_maps.end()) {
+		return cached->second;
+	}
+
+	// backward bfs from dest: a cell is one further than the closest layer it can reach in one move
+	const vector<Bitboard>& reach = this->getReachTable(robot);
+	vector<uint8_t> distances(NUM_CELLS, UNREACHABLE_DISTANCE);
+	distances[dest_cell] = 0;
+	Bitboard frontier;
+	frontier.set(dest_cell);
+
+	for (int distance = 1; frontier.any(); distance++) {
+		Bitboard next_frontier;
+		for (int cell = 0; cell < NUM_CELLS; cell++) {
+			if (distances[cell] == UNREACHABLE_DISTANCE && (reach[cell] & frontier).any()) {
+				distances[cell] = distance;
+				next_frontier.set(cell);
+			}
+		}
+		frontier = next_frontier;
+	}
+
+	return this->distance_maps.insert(make_pair(key, distances)).first->second;
+}
+
+int Board::slideStop(int cell, int direction, uint16_t line_occupancy) const {
+	int line = lineOf(cell, direction);
+	int index = indexOnLine(cell, direction);
+	uint32_t walls = this->line_walls[direction][line];
+
+	// a robot at index i stops the slide at the index before it, so shifting the occupancy back by one
+	// puts robots and walls in the same terms. the slide ends at the nearest of them from index on.
+	// the board edge is always a wall, so there is one
+	int stop_index;
+	if (direction == SOUTH || direction == EAST) {
+		stop_index = __builtin_ctz((walls | (line_occupancy >> 1)) & (0xffffu << index));
+	} else {
+		stop_index = 31 - __builtin_clz((walls | (uint32_t(line_occupancy) << 1)) & ((2u << index) - 1));
+	}
+	return direction == EAST || direction == WEST ? cellOf(line, stop_index) : cellOf(stop_index, line);
 }
 
 
@@ -302,513 +608,437 @@ void Board::display(const RobotArrangement& robots, const Position& dest) const
 
 bool Board::makeMove(Move move, RobotArrangement* robot_positions) const {
 
-	string moving_robot_color = getColor(move);
-	string direction = getDirection(move);
-
-	if (direction == "east") {
-		return this->eastMove(moving_robot_color, robot_positions);
-	} else if (direction == "west") {
-		return this->westMove(moving_robot_color, robot_positions);
-	} else if (direction == "north") {
-		return this->northMove(moving_robot_color, robot_positions);
-	} else if (direction == "south") {
-		return this->southMove(moving_robot_color, robot_positions);
-	}
-
-	return true;
-}
-
-
-bool Board::eastMove(const string& moving_robot_color, RobotArrangement* robot_positions) const {
-
-	Position initial_position = robot_positions->getPosition(moving_robot_color);
-	int moving_robot_row = robot_positions->getRow(moving_robot_color);
-	int moving_robot_col = robot_positions->getCol(moving_robot_color);
-	bool moving_robot_above_diag = robot_positions->getAboveDiag(moving_robot_color);
-	bool initial_moving_robot_above_diag = moving_robot_above_diag;
-
-	// look for first barrier east, could be row barrier (vertical), a diag barrier or another robot
-	int first_barrier_east = BOARD_DIMENSION;
-	string first_barrier_type = "barrier";
-
-	// search for that first barrier going east
-	for (int col = moving_robot_col; col < BOARD_DIMENSION; col++) {
+	// compiled boards resolve diag free rays with a table lookup
+	if (this->compiled) {
+		int moving_robot = getRobotIndex(move);
+		int direction = getDirectionIndex(move);
+		const string& moving_robot_color = all_colors[moving_robot];
+		Position initial_position = robot_positions->getPosition(moving_robot_color);
+		int start = cellOf(initial_position.getRow(), initial_position.getCol());
+
+		if (!this->slow_rays[direction].test(start)) {
+			uint16_t line_occupancy = 0;
+			for (int robot = 0; robot < NUM_ROBOTS; robot++) {
+				const string& color = all_colors[robot];
+				int cell = cellOf(robot_positions->getRow(color), robot_positions->getCol(color));
+				if (robot != moving_robot && lineOf(cell, direction) == lineOf(start, direction)) {
+					line_occupancy |= 1 << indexOnLine(cell, direction);
+				}
+			}
 
-		// check if there is a robot on the square
-		bool is_blocker_robot = robot_positions->isRobotAt(moving_robot_row, col, {moving_robot_color});
-		if (is_blocker_robot) {
-			first_barrier_east = col;
-			first_barrier_type = "robot";
-			break;
+			int stop = this->slideStop(start, direction, line_occupancy);
+			if (stop == start) {
+				return false;
+			}
+			// a ray without diags never stops on one
+			robot_positions->setRobot(moving_robot_color, Position(rowOf(stop), colOf(stop), false));
+			return true;
 		}
 
-		// check if there is a diag barrier
-		if (this->hasDiagBarrier(moving_robot_row, col)) {
-			DiagBarrier diag = this->getDiagBarrier(moving_robot_row, col);
-
-			// if the diag is same color, passes through
-			// change above/below diag, in case there is a same color diag followed immediately by a barrier
-			if (diag.getColor() == moving_robot_color) {
-				moving_robot_above_diag = diag.isForward() ? false : true;
+		// rays that touch a diag follow their precomputed path
+		Bitboard occupied;
+		for (int robot = 0; robot < NUM_ROBOTS; robot++) {
+			const string& color = all_colors[robot];
+			if (robot != moving_robot) {
+				occupied.set(cellOf(robot_positions->getRow(color), robot_positions->getCol(color)));
 			}
+		}
+		bool initial_above_diag = initial_position.getAboveDiag() && this->diag_cells.test(start);
+		bool above_diag = initial_above_diag;
+		int stop = this->diagSlideStop(start, direction, moving_robot, &above_diag, occupied);
+		if (stop == start && above_diag == initial_above_diag) {
+			return false;
+		}
+		robot_positions->setRobot(moving_robot_color, Position(rowOf(stop), colOf(stop), above_diag));
+		return true;
+	}
 
-			// if diag is of different color, it will deflect
-			else {
-				if (diag.isForward()) {
-					// if diag is initially on a forward diag square, and is already below diag, nothing
-					if (!(col == moving_robot_col && !moving_robot_above_diag)) {
-						first_barrier_east = col;
-						first_barrier_type = "forward";
-						moving_robot_above_diag = true;
-						break;
-					}
-				}
+	return this->slowMove(getDirectionIndex(move), getRobotIndex(move), robot_positions);
+}
 
-				else if (diag.isBackward()) {
+bool Board::makeMove(Move move, CompactArrangement* robot_positions) const {
 
-					// if robot is initially on back diag square, and is above that diag, nothing happens
-					if (!(col == moving_robot_col && moving_robot_above_diag)) {
-						first_barrier_east = col;
-						first_barrier_type = "backward";
-						moving_robot_above_diag = false;
-						break;
-					}
-				}
+	int moving_robot = getRobotIndex(move);
+	int direction = getDirectionIndex(move);
+	int start = robot_positions->getCell(moving_robot);
+
+	if (this->compiled && !this->slow_rays[direction].test(start)) {
+		uint16_t line_occupancy = 0;
+		int line = lineOf(start, direction);
+		for (int robot = 0; robot < NUM_ROBOTS; robot++) {
+			int cell = robot_positions->getCell(robot);
+			if (robot != moving_robot && lineOf(cell, direction) == line) {
+				line_occupancy |= 1 << indexOnLine(cell, direction);
 			}
 		}
 
-		// if neither a robot nor a diag, check if barrier
-		if (this->hasRowBarrier(moving_robot_row, col + 1)) {
-			first_barrier_east = col + 1;
-			first_barrier_type = "barrier";
-			break;
+		int stop = this->slideStop(start, direction, line_occupancy);
+		if (stop == start) {
+			return false;
 		}
-
+		// a ray without diags never stops on one
+		robot_positions->setRobot(moving_robot, stop, false);
+		return true;
 	}
 
-	// based on the type of the first barrier decide what to do
-
-	if (first_barrier_type == "barrier" || first_barrier_type == "robot") {
-		// if barrier or robot, moving robot stops
-		Position new_position = Position(moving_robot_row, first_barrier_east - 1, moving_robot_above_diag);
-		robot_positions->setRobot(moving_robot_color, new_position);
-		return initial_position != new_position;
-
-	} else if (first_barrier_type == "forward") {
-		// if forward diag, deflects north
-		Position new_position = Position(moving_robot_row, first_barrier_east, moving_robot_above_diag);
-		robot_positions->setRobot(moving_robot_color, new_position);
-		this->northMove(moving_robot_color, robot_positions);
-		new_position = robot_positions->getPosition(moving_robot_color);
-		return initial_position != new_position;
-	
+	if (this->compiled) {
+		// rays that touch a diag follow their precomputed path
+		Bitboard occupied;
+		for (int robot = 0; robot < NUM_ROBOTS; robot++) {
+			if (robot != moving_robot) {
+				occupied.set(robot_positions->getCell(robot));
+			}
+		}
+		bool initial_above_diag = robot_positions->getAboveDiag(moving_robot) && this->diag_cells.test(start);
+		bool above_diag = initial_above_diag;
+		int stop = this->diagSlideStop(start, direction, moving_robot, &above_diag, occupied);
+		if (stop == start && above_diag == initial_above_diag) {
+			return false;
+		}
+		robot_positions->setRobot(moving_robot, stop, above_diag);
+		return true;
 	}
 
-	else if (first_barrier_type == "backward") {
-		// if backward diag, deflects south
-		Position new_position = Position(moving_robot_row, first_barrier_east, moving_robot_above_diag);
-		robot_positions->setRobot(moving_robot_color, new_position);
-		this->southMove(moving_robot_color, robot_positions);
-		new_position = robot_positions->getPosition(moving_robot_color);
-		return initial_position != new_position;
+	// an uncompiled board goes through the move kernel
+	int rows[NUM_ROBOTS_MAX];
+	int cols[NUM_ROBOTS_MAX];
+	for (int robot = 0; robot < NUM_ROBOTS; robot++) {
+		rows[robot] = rowOf(robot_positions->getCell(robot));
+		cols[robot] = colOf(robot_positions->getCell(robot));
 	}
-
-	ASSERT(false, "invalid barrier type " << first_barrier_type);
-
-
+	bool above_diag = robot_positions->getAboveDiag(moving_robot);
+	// like the compiled moves, a move that does nothing leaves the arrangement as it was
+	bool moved = this->slideRobot(direction, moving_robot, rows, cols, &above_diag);
+	if (moved) {
+		robot_positions->setRobot(moving_robot, cellOf(rows[moving_robot], cols[moving_robot]), above_diag);
+	}
+	return moved;
 }
 
+int Board::generateChildren(const CompactArrangement& robot_positions, CompactArrangement* children,
+	Move* child_moves) const {
 
-bool Board::westMove(const string& moving_robot_color, RobotArrangement* robot_positions) const {
-	
-	Position initial_position = robot_positions->getPosition(moving_robot_color);
-	int moving_robot_row = robot_positions->getRow(moving_robot_color);
-	int moving_robot_col = robot_positions->getCol(moving_robot_color);
-	bool moving_robot_above_diag = robot_positions->getAboveDiag(moving_robot_color);
-	bool initial_moving_robot_above_diag = moving_robot_above_diag;
-
-	// look for first barrier west, could be row barrier (vertical), a diag barrier or another robot
-	int first_barrier_west = 0;
-	string first_barrier_type = "barrier";
-
-	// search for that first barrier going east
-	for (int col = moving_robot_col; col >= 0; col--) {
-
-		// check if there is a robot on the square
-		bool is_blocker_robot = robot_positions->isRobotAt(moving_robot_row, col, {moving_robot_color});
-		if (is_blocker_robot) {
-			first_barrier_west = col;
-			first_barrier_type = "robot";
-			break;
-		}
-
-		// check if there is a diag barrier
-		if (this->hasDiagBarrier(moving_robot_row, col)) {
-			DiagBarrier diag = this->getDiagBarrier(moving_robot_row, col);
-
-			// if the diag is same color, passes through
-			// change above/below diag, in case there is a same color diag followed immediately by a barrier
-			if (diag.getColor() == moving_robot_color) {
-				moving_robot_above_diag = diag.isForward() ? true : false;
+	int num_children = 0;
+	if (!this->compiled) {
+		for (Move move : all_moves) {
+			children[num_children] = robot_positions;
+			if (this->makeMove(move, &children[num_children])) {
+				child_moves[num_children++] = move;
 			}
+		}
+		return num_children;
+	}
 
-			// if diag is of different color, it will deflect
-			else {
-				if (diag.isForward()) {
-					// if diag is initially on a forward diag square, and is already below diag, nothing
-					if (!(col == moving_robot_col && moving_robot_above_diag)) {
-						first_barrier_west = col;
-						first_barrier_type = "forward";
-						moving_robot_above_diag = false;
-						break;
-					}
+	int cells[NUM_ROBOTS_MAX];
+	alignas(32) int16_t starts[NUM_MOVES];
+	alignas(32) int16_t stops[NUM_MOVES];
+	for (int robot = 0; robot < NUM_ROBOTS_MAX; robot++) {
+		cells[robot] = robot_positions.getCell(robot);
+		for (int direction = 0; direction < NUM_DIRECTIONS; direction++) {
+			starts[robot * NUM_DIRECTIONS + direction] = cells[robot];
+			stops[robot * NUM_DIRECTIONS + direction] = this->stop_cells[direction][cells[robot]];
+		}
+	}
+	slideLanes(starts, stops, cells, NUM_ROBOTS);
+
+	for (int robot = 0; robot < NUM_ROBOTS; robot++) {
+		for (int direction = 0; direction < NUM_DIRECTIONS; direction++) {
+			Move move = direction * NUM_ROBOTS + robot;
+			CompactArrangement& child = children[num_children];
+			child = robot_positions;
+			if (this->slow_directions[cells[robot]] & (1 << direction)) {
+				if (!this->makeMove(move, &child)) {
+					continue;
 				}
-
-				else if (diag.isBackward()) {
-
-					// if robot is initially on back diag square, and is above that diag, nothing happens
-					if (!(col == moving_robot_col && !moving_robot_above_diag)) {
-						first_barrier_west = col;
-						first_barrier_type = "backward";
-						moving_robot_above_diag = true;
-						break;
-					}
+			} else {
+				int stop = stops[robot * NUM_DIRECTIONS + direction];
+				if (stop == cells[robot]) {
+					continue;
 				}
+				child.setRobot(robot, stop, false);
 			}
-		}
-
-		// if neither a robot nor a diag, check if barrier
-		if (this->hasRowBarrier(moving_robot_row, col)) {
-			first_barrier_west = col;
-			first_barrier_type = "barrier";
-			break;
+			child_moves[num_children++] = move;
 		}
 	}
-
-	// based on the type of the first barrier decide what to do
-	if (first_barrier_type == "barrier") {
-		// if barrier, stops
-		Position new_position = Position(moving_robot_row, first_barrier_west, moving_robot_above_diag);
-		robot_positions->setRobot(moving_robot_color, new_position);
-		return initial_position != new_position;
-	}
-
-	else if (first_barrier_type == "robot") {
-		// if barrier or robot, moving robot stops
-		Position new_position = Position(moving_robot_row, first_barrier_west + 1, moving_robot_above_diag);
-		robot_positions->setRobot(moving_robot_color, new_position);
-		return initial_position != new_position;
-
-	} else if (first_barrier_type == "forward") {
-		// if forward diag, deflects south
-		Position new_position = Position(moving_robot_row, first_barrier_west, moving_robot_above_diag);
-		robot_positions->setRobot(moving_robot_color, new_position);
-		this->southMove(moving_robot_color, robot_positions);
-		new_position = robot_positions->getPosition(moving_robot_color);
-		return initial_position != new_position;
-	}
-
-	else if (first_barrier_type == "backward") {
-		// if backward diag, deflects north
-		Position new_position = Position(moving_robot_row, first_barrier_west, moving_robot_above_diag);
-		robot_positions->setRobot(moving_robot_color, new_position);
-		this->northMove(moving_robot_color, robot_positions);
-		new_position = robot_positions->getPosition(moving_robot_color);
-		return initial_position != new_position;
-	}
-
-	ASSERT(false, "invalid barrier type " << first_barrier_type);
-
+	return num_children;
 }
 
 
-
-
-
-bool Board::northMove(const string& moving_robot_color, RobotArrangement* robot_positions) const {
-	
-	Position initial_position = robot_positions->getPosition(moving_robot_color);
-	int moving_robot_row = robot_positions->getRow(moving_robot_color);
-	int moving_robot_col = robot_positions->getCol(moving_robot_color);
-	bool moving_robot_above_diag = robot_positions->getAboveDiag(moving_robot_color);
-	bool initial_moving_robot_above_diag = moving_robot_above_diag;
-
-	// look for first barrier south, could be col barrier (horizontal), a diag barrier or another robot
-	int first_barrier_north = 0;
-	string first_barrier_type = "barrier";
-
-	// search for that first barrier going east
-	for (int row = moving_robot_row; row >= 0; row--) {
-
-		// check if there is a robot on the square
-		bool is_blocker_robot = robot_positions->isRobotAt(row, moving_robot_col, {moving_robot_color});
+// what the move kernel needs to know about each direction. the above diag bits and the exemptions for a robot
+// that starts on a diag are exactly those of the original per direction move functions, including where they
+// are not symmetric (a robot moving north is exempt from both kinds of diag when above it)
+template <int DIRECTION> struct SlideTraits;
+
+template <> struct SlideTraits<NORTH> {
+	static const int ROW_STEP = -1, COL_STEP = 0;
+	static const bool SAME_COLOR_FORWARD_ABOVE = true; // above diag after passing a same color forward diag, a backward one gives the opposite
+	static const bool FORWARD_EXEMPT_ABOVE = true; // a robot starting on a forward diag with this above diag bit is not deflected
+	static const bool FORWARD_ABOVE = false; // above diag bit after a forward diag deflects it
+	static const int FORWARD_TURN = EAST;
+	static const bool BACKWARD_EXEMPT_ABOVE = true;
+	static const bool BACKWARD_ABOVE = false;
+	static const int BACKWARD_TURN = WEST;
+};
+
+template <> struct SlideTraits<SOUTH> {
+	static const int ROW_STEP = 1, COL_STEP = 0;
+	static const bool SAME_COLOR_FORWARD_ABOVE = false;
+	static const bool FORWARD_EXEMPT_ABOVE = false;
+	static const bool FORWARD_ABOVE = true;
+	static const int FORWARD_TURN = WEST;
+	static const bool BACKWARD_EXEMPT_ABOVE = false;
+	static const bool BACKWARD_ABOVE = true;
+	static const int BACKWARD_TURN = EAST;
+};
+
+template <> struct SlideTraits<EAST> {
+	static const int ROW_STEP = 0, COL_STEP = 1;
+	static const bool SAME_COLOR_FORWARD_ABOVE = false;
+	static const bool FORWARD_EXEMPT_ABOVE = false;
+	static const bool FORWARD_ABOVE = true;
+	static const int FORWARD_TURN = NORTH;
+	static const bool BACKWARD_EXEMPT_ABOVE = true;
+	static const bool BACKWARD_ABOVE = false;
+	static const int BACKWARD_TURN = SOUTH;
+};
+
+template <> struct SlideTraits<WEST> {
+	static const int ROW_STEP = 0, COL_STEP = -1;
+	static const bool SAME_COLOR_FORWARD_ABOVE = true;
+	static const bool FORWARD_EXEMPT_ABOVE = true;
+	static const bool FORWARD_ABOVE = false;
+	static const int FORWARD_TURN = SOUTH;
+	static const bool BACKWARD_EXEMPT_ABOVE = false;
+	static const bool BACKWARD_ABOVE = true;
+	static const int BACKWARD_TURN = NORTH;
+};
+
+// what ends one straight slide
+enum SlideBlocker { WALL_BLOCKER, ROBOT_BLOCKER, FORWARD_DIAG_BLOCKER, BACKWARD_DIAG_BLOCKER };
+
+template <int DIRECTION>
+void Board::slide(int moving_robot, int* rows, int* cols, bool* above_diag, vector<uint16_t>* path) const {
+	typedef SlideTraits<DIRECTION> Traits;
+	int start_row = rows[moving_robot];
+	int start_col = cols[moving_robot];
+	int row = start_row;
+	int col = start_col;
+
+	// walk the cells from the start until a robot, a deflecting diag or a wall
+	SlideBlocker blocker = WALL_BLOCKER;
+	while (true) {
+		bool is_blocker_robot = false;
+		for (int robot = 0; robot < NUM_ROBOTS; robot++) {
+			is_blocker_robot = is_blocker_robot || (robot != moving_robot && rows[robot] == row && cols[robot] == col);
+		}
 		if (is_blocker_robot) {
-			first_barrier_north = row;
-			first_barrier_type = "robot";
+			blocker = ROBOT_BLOCKER;
 			break;
 		}
 
-		// check if there is a diag barrier
-		if (this->hasDiagBarrier(row, moving_robot_col)) {
-			DiagBarrier diag = this->getDiagBarrier(row, moving_robot_col);
-
-			// if the diag is same color, passes through
-			// change above/below diag, in case there is a same color diag followed immediately by a barrier
-			if (diag.getColor() == moving_robot_color) {
-				moving_robot_above_diag = diag.isForward() ? true : false;
-			}
-
-			// if diag is of different color, it will deflect
-			else {
-				if (diag.isForward()) {
-					// if diag is initially on a forward diag square, and is already below diag, nothing
-					if (!(row == moving_robot_row && moving_robot_above_diag)) {
-						first_barrier_north = row;
-						first_barrier_type = "forward";
-						moving_robot_above_diag = false;
-						break;
-					}
-				}
-
-				else if (diag.isBackward()) {
-
-					// if robot is initially on back diag square, and is above that diag, nothing happens
-					if (!(row == moving_robot_row && moving_robot_above_diag)) {
-						first_barrier_north = row;
-						first_barrier_type = "backward";
-						moving_robot_above_diag = false;
-						break;
-					}
-				}
+		const DiagBarrier* diag = this->findDiagBarrier(row, col);
+		if (diag != NULL) {
+			bool at_start = row == start_row && col == start_col;
+			if (diag->getRobot() == moving_robot) {
+				// passes through, still noting the side in case a wall follows right away
+				*above_diag = diag->isForward() == Traits::SAME_COLOR_FORWARD_ABOVE;
+			} else if (diag->isForward() && !(at_start && *above_diag == Traits::FORWARD_EXEMPT_ABOVE)) {
+				*above_diag = Traits::FORWARD_ABOVE;
+				blocker = FORWARD_DIAG_BLOCKER;
+			} else if (diag->isBackward() && !(at_start && *above_diag == Traits::BACKWARD_EXEMPT_ABOVE)) {
+				*above_diag = Traits::BACKWARD_ABOVE;
+				blocker = BACKWARD_DIAG_BLOCKER;
 			}
 		}
-
-		// if neither a robot nor a diag, check if barrier
-		if (this->hasColBarrier(moving_robot_col, row)) {
-			first_barrier_north = row;
-			first_barrier_type = "barrier";
+		if (path != NULL) {
+			ASSERT(path->size() < 4 * NUM_CELLS, "slide from " << start_row << ", " << start_col << " never ends");
+			// off a diag the bit means nothing, and is left clear so each state has one key
+			path->push_back(cellOf(row, col) << 1 | (*above_diag && diag != NULL));
+		}
+		if (blocker != WALL_BLOCKER) {
 			break;
 		}
 
+		// barriers on the far side of the cell, the board edge counts as one
+		bool wall_ahead = Traits::COL_STEP != 0 ?
+			this->hasRowBarrier(row, col + (Traits::COL_STEP > 0)) : this->hasColBarrier(col, row + (Traits::ROW_STEP > 0));
+		int next_row = row + Traits::ROW_STEP;
+		int next_col = col + Traits::COL_STEP;
+		if (wall_ahead || next_row < 0 || next_row >= BOARD_DIMENSION || next_col < 0 || next_col >= BOARD_DIMENSION) {
+			break;
+		}
+		row = next_row;
+		col = next_col;
 	}
 
-	// based on the type of the first barrier decide what to do
-
-	if (first_barrier_type == "barrier") {
-		Position new_position = Position(first_barrier_north, moving_robot_col, moving_robot_above_diag);
-		robot_positions->setRobot(moving_robot_color, new_position);
-		return initial_position != new_position;
-	}
-
-	else if (first_barrier_type == "robot") {
-		Position new_position = Position(first_barrier_north + 1, moving_robot_col, moving_robot_above_diag);
-		robot_positions->setRobot(moving_robot_color, new_position);
-		return initial_position != new_position;
-	}
-
-	else if (first_barrier_type == "forward") {
-		// if forward diag, deflects east
-		Position new_position = Position(first_barrier_north, moving_robot_col, moving_robot_above_diag);
-		robot_positions->setRobot(moving_robot_color, new_position);
-		this->eastMove(moving_robot_color, robot_positions);
-		new_position = robot_positions->getPosition(moving_robot_color);
-		return initial_position != new_position;
+	// a robot stops the slide on the cell before it, diags turn it from their own cell
+	if (blocker == ROBOT_BLOCKER) {
+		row -= Traits::ROW_STEP;
+		col -= Traits::COL_STEP;
 	}
-
-	else if (first_barrier_type == "backward") {
-		// if backward diag, deflects west
-		Position new_position = Position(first_barrier_north, moving_robot_col, moving_robot_above_diag);
-		robot_positions->setRobot(moving_robot_color, new_position);
-		this->westMove(moving_robot_color, robot_positions);
-		new_position = robot_positions->getPosition(moving_robot_color);
-		return initial_position != new_position;
+	rows[moving_robot] = row;
+	cols[moving_robot] = col;
+	if (blocker == FORWARD_DIAG_BLOCKER) {
+		this->slide<Traits::FORWARD_TURN>(moving_robot, rows, cols, above_diag, path);
+	} else if (blocker == BACKWARD_DIAG_BLOCKER) {
+		this->slide<Traits::BACKWARD_TURN>(moving_robot, rows, cols, above_diag, path);
 	}
-
-	ASSERT(false, "invalid barrier type " << first_barrier_type);
-
-
 }
 
+const DiagPath& Board::getDiagPath(int cell, int direction, int robot, bool above_diag) const {
+	int index = this->diag_path_index[((cell * NUM_DIRECTIONS + direction) * NUM_ROBOTS_MAX + robot) * 2 + above_diag];
+	DEBUG_ASSERT(index != -1, "no diag path from " << cell << " in direction " << direction);
+	return this->diag_paths[index];
+}
 
-bool Board::southMove(const string& moving_robot_color, RobotArrangement* robot_positions) const {
-	
-	Position initial_position = robot_positions->getPosition(moving_robot_color);
-	int moving_robot_row = robot_positions->getRow(moving_robot_color);
-	int moving_robot_col = robot_positions->getCol(moving_robot_color);
-	bool moving_robot_above_diag = robot_positions->getAboveDiag(moving_robot_color);
-	bool initial_moving_robot_above_diag = moving_robot_above_diag;
-
-	// look for first barrier south, could be col barrier (horizontal), a diag barrier or another robot
-	int first_barrier_south = BOARD_DIMENSION;
-	string first_barrier_type = "barrier";
-
-
-	// search for that first barrier going east
-	for (int row = moving_robot_row; row < BOARD_DIMENSION; row++) {
-		// check if there is a robot on the square
-		bool is_blocker_robot = robot_positions->isRobotAt(row, moving_robot_col, {moving_robot_color});
-		if (is_blocker_robot) {
-			first_barrier_south = row;
-			first_barrier_type = "robot";
-			break;
-		}
-
-		// check if there is a diag barrier
-		if (this->hasDiagBarrier(row, moving_robot_col)) {
-			DiagBarrier diag = this->getDiagBarrier(row, moving_robot_col);
-
-			// if the diag is same color, passes through
-			// change above/below diag, in case there is a same color diag followed immediately by a barrier
-			if (diag.getColor() == moving_robot_color) {
-				moving_robot_above_diag = diag.isForward() ? false : true;
-			}
-
-			// if diag is of different color, it will deflect
-			else {
-				if (diag.isForward()) {
-					// if diag is initially on a forward diag square, and is already below diag, nothing
-					if (!(row == moving_robot_row && !moving_robot_above_diag)) {
-						first_barrier_south = row;
-						first_barrier_type = "forward";
-						moving_robot_above_diag = true;
-						break;
-					}
-				}
-
-				else if (diag.isBackward()) {
-					// if robot is initially on back diag square, and is below that diag, nothing happens
-					if (!(row == moving_robot_row && !moving_robot_above_diag)) {
-						first_barrier_south = row;
-						first_barrier_type = "backward";
-						moving_robot_above_diag = true;
-						break;
-					}
-				}
+int Board::diagSlideStop(int cell, int direction, int robot, bool* above_diag, const Bitboard& occupied) const {
+	const DiagPath& path = this->getDiagPath(cell, direction, robot, *above_diag);
+	const uint16_t* steps = &this->diag_path_steps[path.first_step];
+
+	// the first robot along the path stops the slide on the step before it, the start is never occupied
+	int last_step = path.num_steps - 1;
+	if ((path.cells & occupied).any()) {
+		for (int step = 1; step < path.num_steps; step++) {
+			if (occupied.test(steps[step] >> 1)) {
+				last_step = step - 1;
+				break;
 			}
 		}
-
-		// if neither a robot nor a diag, check if barrier
-		if (this->hasColBarrier(moving_robot_col, row + 1)) {
-			first_barrier_south = row + 1;
-			first_barrier_type = "barrier";
-			break;
-		}
-
 	}
+	*above_diag = steps[last_step] & 1;
+	return steps[last_step] >> 1;
+}
 
-	// based on the type of the first barrier decide what to do
-	if (first_barrier_type == "barrier" || first_barrier_type == "robot") {
-		Position new_position = Position(first_barrier_south - 1, moving_robot_col, moving_robot_above_diag);
-		robot_positions->setRobot(moving_robot_color, new_position);
-		return initial_position != new_position;
+bool Board::slideRobot(int direction, int moving_robot, int* rows, int* cols, bool* above_diag,
+	vector<uint16_t>* path) const {
+	int start_row = rows[moving_robot];
+	int start_col = cols[moving_robot];
+	bool start_above_diag = *above_diag && this->hasDiagBarrier(start_row, start_col);
+
+	switch (direction) {
+		case NORTH: this->slide<NORTH>(moving_robot, rows, cols, above_diag, path); break;
+		case SOUTH: this->slide<SOUTH>(moving_robot, rows, cols, above_diag, path); break;
+		case EAST: this->slide<EAST>(moving_robot, rows, cols, above_diag, path); break;
+		case WEST: this->slide<WEST>(moving_robot, rows, cols, above_diag, path); break;
+		default: ASSERT(false, "invalid direction " << direction);
 	}
+	*above_diag = *above_diag && this->hasDiagBarrier(rows[moving_robot], cols[moving_robot]);
+	return rows[moving_robot] != start_row || cols[moving_robot] != start_col || *above_diag != start_above_diag;
+}
 
-	else if (first_barrier_type == "forward") {
-		// if forward diag, deflects west
-		Position new_position = Position(first_barrier_south, moving_robot_col, moving_robot_above_diag);
-		robot_positions->setRobot(moving_robot_color, new_position);
-		this->westMove(moving_robot_color, robot_positions);
-		new_position = robot_positions->getPosition(moving_robot_color);
-		return initial_position != new_position;
+bool Board::slowMove(int direction, int moving_robot, RobotArrangement* robot_positions) const {
+	int rows[NUM_ROBOTS_MAX];
+	int cols[NUM_ROBOTS_MAX];
+	for (int robot = 0; robot < NUM_ROBOTS; robot++) {
+		rows[robot] = robot_positions->getRow(all_colors[robot]);
+		cols[robot] = robot_positions->getCol(all_colors[robot]);
 	}
+	const string& moving_robot_color = all_colors[moving_robot];
+	bool above_diag = robot_positions->getAboveDiag(moving_robot_color);
 
-	else if (first_barrier_type == "backward") {
-		// if backward diag, deflects east
-		Position new_position = Position(first_barrier_south, moving_robot_col, moving_robot_above_diag);
-		robot_positions->setRobot(moving_robot_color, new_position);
-		this->eastMove(moving_robot_color, robot_positions);
-		new_position = robot_positions->getPosition(moving_robot_color);
-		return initial_position != new_position;
+	bool moved = this->slideRobot(direction, moving_robot, rows, cols, &above_diag);
+	if (moved) {
+		robot_positions->setRobot(moving_robot_color, Position(rows[moving_robot], cols[moving_robot], above_diag));
 	}
-
-	ASSERT(false, "invalid barrier type " << first_barrier_type);
-
+	return moved;
 }
 
+bool Board::eastMove(const string& moving_robot_color, RobotArrangement* robot_positions) const {
+	return this->slowMove(EAST, getRobotIndex(moving_robot_color), robot_positions);
+}
 
+bool Board::westMove(const string& moving_robot_color, RobotArrangement* robot_positions) const {
+	return this->slowMove(WEST, getRobotIndex(moving_robot_color), robot_positions);
+}
 
+bool Board::northMove(const string& moving_robot_color, RobotArrangement* robot_positions) const {
+	return this->slowMove(NORTH, getRobotIndex(moving_robot_color), robot_positions);
+}
 
+bool Board::southMove(const string& moving_robot_color, RobotArrangement* robot_positions) const {
+	return this->slowMove(SOUTH, getRobotIndex(moving_robot_color), robot_positions);
+}
 
 
-void buildBoard(Board* board, const Quadrant& quadrant1, const Quadrant& quadrant2,
-	const Quadrant& quadrant3, const Quadrant& quadrant4) {
-
-	// quadrant 1
-	for (int row = 0; row <= QUADRANT_DIMENSION; row++) {
-		for (int col = 0; col <= QUADRANT_DIMENSION; col++) {
-			if (quadrant1.hasRowBarrier(row, col)) {
-				board->setRowBarrier(row, col);
-			}
+// where a barrier of the quadrant in the given position lands on the board: position 0 is as is,
+// 1 is turned a quarter clockwise, 2 a quarter counterclockwise and 3 half way round.
+// turning a quarter swaps row and col barriers, and flips diags
+static void placeRowBarrier(int position, const QuadrantBarrier& barrier, vector<vector<int>>* row_barriers,
+	vector<vector<int>>* col_barriers) {
+	int row = barrier.line;
+	int col = barrier.index;
+	int last = 2 * QUADRANT_DIMENSION - 1;
+	switch (position) {
+		case 0: (*row_barriers)[row].push_back(col); break;
+		case 1: (*col_barriers)[last - row].push_back(col); break;
+		case 2: (*col_barriers)[row].push_back(last + 1 - col); break;
+		case 3: (*row_barriers)[last - row].push_back(last + 1 - col); break;
+	}
+}
 
-			if (quadrant1.hasColBarrier(col, row)) {
-				board->setColBarrier(col, row);
-			}
+static void placeColBarrier(int position, const QuadrantBarrier& barrier, vector<vector<int>>* row_barriers,
+	vector<vector<int>>* col_barriers) {
+	int col = barrier.line;
+	int row = barrier.index;
+	int last = 2 * QUADRANT_DIMENSION - 1;
+	switch (position) {
+		case 0: (*col_barriers)[col].push_back(row); break;
+		case 1: (*row_barriers)[col].push_back(last + 1 - row); break;
+		case 2: (*row_barriers)[last - col].push_back(row); break;
+		case 3: (*col_barriers)[last - col].push_back(last + 1 - row); break;
+	}
+}
 
-			if (quadrant1.hasDiagBarrier(row, col)) {
-				DiagBarrier db = quadrant1.getDiagBarrier(row, col);
-				board->setDiagBarrier(row, col, db.getColor(), db.isForward());
-			}
-		}
+static void placeDiag(Board* board, int position, const QuadrantDiag& diag) {
+	int last = 2 * QUADRANT_DIMENSION - 1;
+	const string& color = all_colors[diag.robot];
+	switch (position) {
+		case 0: board->setDiagBarrier(diag.row, diag.col, color, diag.is_forward); break;
+		case 1: board->setDiagBarrier(diag.col, last - diag.row, color, !diag.is_forward); break;
+		case 2: board->setDiagBarrier(last - diag.col, diag.row, color, !diag.is_forward); break;
+		case 3: board->setDiagBarrier(last - diag.row, last - diag.col, color, diag.is_forward); break;
 	}
-	
+}
 
+void buildBoard(Board* board, int quadrant1, int quadrant2, int quadrant3, int quadrant4) {
+	ASSERT(BOARD_DIMENSION == 2 * QUADRANT_DIMENSION, "quadrant tables need a " << 2 * QUADRANT_DIMENSION << " board");
 
-	// quadrant 2
-	for (int row = 0; row <= QUADRANT_DIMENSION; row++) {
-		for (int col = 0; col <= QUADRANT_DIMENSION; col++) {
-			if (quadrant2.hasRowBarrier(row, col)) {
-				board->setColBarrier((QUADRANT_DIMENSION - 1) + (QUADRANT_DIMENSION - row), col);
-			}
+	// collect every barrier first, so each list is sorted once instead of on every insert
+	vector<vector<int>> row_barriers(BOARD_DIMENSION, vector<int>{0, BOARD_DIMENSION + 1});
+	vector<vector<int>> col_barriers(BOARD_DIMENSION, vector<int>{0, BOARD_DIMENSION});
 
-			if (quadrant2.hasColBarrier(col, row)) {
-				board->setRowBarrier(col, QUADRANT_DIMENSION + (QUADRANT_DIMENSION - row));
-			}
+	int quadrant_nums[4] = {quadrant1, quadrant2, quadrant3, quadrant4};
+	for (int position = 0; position < 4; position++) {
+		const QuadrantTable& table = getQuadrantTable(quadrant_nums[position]);
 
-			if (quadrant2.hasDiagBarrier(row, col)) {
-				DiagBarrier db = quadrant1.getDiagBarrier(row, col);
-				board->setDiagBarrier(col, (QUADRANT_DIMENSION - 1) + (QUADRANT_DIMENSION - row), db.getColor(), !db.isForward());
-			}
+		// the quadrant's outer edges
+		for (int line = 0; line <= QUADRANT_DIMENSION; line++) {
+			placeRowBarrier(position, {line, 0}, &row_barriers, &col_barriers);
+			placeColBarrier(position, {line, 0}, &row_barriers, &col_barriers);
 		}
-	}
-
-	// quadrant 3
-	for (int row = 0; row <= QUADRANT_DIMENSION; row++) {
-		for (int col = 0; col <= QUADRANT_DIMENSION; col++) {
-			if (quadrant3.hasRowBarrier(row, col)) {
-				board->setColBarrier(row, QUADRANT_DIMENSION + (QUADRANT_DIMENSION - col));
-			}
-
-			if (quadrant3.hasColBarrier(col, row)) {
-				board->setRowBarrier((QUADRANT_DIMENSION - 1) + (QUADRANT_DIMENSION - col), row);
-			}
 
-			if (quadrant3.hasDiagBarrier(row, col)) {
-				DiagBarrier db = quadrant3.getDiagBarrier(row, col);
-				board->setDiagBarrier((QUADRANT_DIMENSION - 1) + (QUADRANT_DIMENSION - col), row, db.getColor(), !db.isForward());
-			}
+		for (int i = 0; i < table.num_row_barriers; i++) {
+			placeRowBarrier(position, table.row_barriers[i], &row_barriers, &col_barriers);
+		}
+		for (int i = 0; i < table.num_col_barriers; i++) {
+			placeColBarrier(position, table.col_barriers[i], &row_barriers, &col_barriers);
+		}
+		for (int i = 0; i < table.num_diags; i++) {
+			placeDiag(board, position, table.diags[i]);
 		}
 	}
 
-	// quadrant 4
-	for (int row = 0; row <= QUADRANT_DIMENSION; row++) {
-		for (int col = 0; col <= QUADRANT_DIMENSION; col++) {
-			if (quadrant4.hasRowBarrier(row, col)) {
-				board->setRowBarrier((QUADRANT_DIMENSION - 1) + (QUADRANT_DIMENSION - row), 
-					QUADRANT_DIMENSION + (QUADRANT_DIMENSION - col));
-			}
-
-			if (quadrant4.hasColBarrier(col, row)) {
-				board->setColBarrier((QUADRANT_DIMENSION - 1) + (QUADRANT_DIMENSION - col), 
-					QUADRANT_DIMENSION + (QUADRANT_DIMENSION - row));
-			}
-
-			if (quadrant4.hasDiagBarrier(row, col)) {
-				DiagBarrier db = quadrant4.getDiagBarrier(row, col);
-				board->setDiagBarrier((QUADRANT_DIMENSION - 1) + (QUADRANT_DIMENSION - row),
-					(QUADRANT_DIMENSION - 1) + (QUADRANT_DIMENSION - row), db.getColor(), db.isForward());
-			}
-		}
+	for (vector<int>& barriers : row_barriers) {
+		sort(barriers.begin(), barriers.end());
+		barriers.erase(unique(barriers.begin(), barriers.end()), barriers.end());
 	}
+	for (vector<int>& barriers : col_barriers) {
+		sort(barriers.begin(), barriers.end());
+		barriers.erase(unique(barriers.begin(), barriers.end()), barriers.end());
+	}
+	board->setBarriers(row_barriers, col_barriers);
+
+	board->compile();
 }
 
 
@@ -1019,38 +1249,30 @@ void testSouthMove() {
 	ASSERT(sameSquare(new_robot_positions.getPosition("blue"), new_blue), "blue wrong");
 }
 
-int main() {
-
+// compares the compiled moves against the slow moves, for every robot in every direction
+void testCompiledMoves() {
+	Board slow_board;
+	createBoardTemp(&slow_board);
 	Board board;
-	buildBoard(&board, quadrant1, quadrant3, quadrant5, quadrant7);
-
-	Position yellow_robot(5, 7);
-	Position red_robot(13, 5);
-	Position green_robot(2, 6);
-	Position blue_robot(10, 9);
-
-	Position dest(14, 9);
-
-	RobotArrangement robot_positions({{"yellow", yellow_robot}, {"red", red_robot}, {"green", green_robot}, {"blue", blue_robot}});
-
-	board.display(robot_positions, dest);
-	string dest_color {"yellow"};
-
-
-	vector<Move> moves;
-	int solution_length = solveRicochetBoard(board, robot_positions, dest, dest_color, &moves);
-	bool solved = solution_length != -1;
-	if (solved) {
-		log("Solution takes " + to_string(solution_length) + " moves");
-		printMoves(moves);
-	} else {
-		log("no solution found");
+	createBoardTemp(&board);
+	board.compile();
+	ASSERT(board.isCompiled() && !slow_board.isCompiled(), "only one board should be compiled");
+
+	vector<Position> positions = {Position(9, 3), Position(5, 2), Position(9, 2), Position(1, 0), Position(6, 10),
+		Position(8, 6), Position(5, 15), Position(1, 12), Position(15, 14), Position(15, 7), Position(0, 8), Position(7, 11)};
+	int num_positions = positions.size();
+
+	for (int i = 0; i + 3 < num_positions; i++) {
+		RobotArrangement robot_positions({{"yellow", positions[i]}, {"red", positions[i + 1]},
+			{"green", positions[i + 2]}, {"blue", positions[i + 3]}});
+
+		for (Move move : all_moves) {
+			RobotArrangement slow_positions(robot_positions);
+			RobotArrangement compiled_positions(robot_positions);
+			bool slow_moved = slow_board.makeMove(move, &slow_positions);
+			bool compiled_moved = board.makeMove(move, &compiled_positions);
+			ASSERT(slow_moved == compiled_moved, "move " << move << " disagrees on moving");
+			ASSERT(encode(slow_positions) == encode(compiled_positions), "move " << move << " disagrees on position");
+		}
 	}
-	
-
-
-
-	//vector<Move> solution;
-	//bool is_solution = solveDepthLimitedDfs(board, robot_positions, dest, dest_color, &solution);
-
-}
\ No newline at end of file
+}
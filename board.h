@@ -7,11 +7,24 @@
 #include <vector>
 #include <map>
 #include <set>
+#include <mutex>
 
 using namespace std;
 
 extern int BOARD_DIMENSION;
 
+// directions, in the order used by the Move encoding (move / NUM_ROBOTS)
+enum Direction { NORTH = 0, SOUTH = 1, EAST = 2, WEST = 3 };
+const int NUM_DIRECTIONS = 4;
+
+// a slide runs along one line of the board, the cell's row for east and west and its col for north and south.
+// lines are indexed by that row or col, and cells along them by their col or row
+inline int lineOf(int cell, int direction) { return direction == EAST || direction == WEST ? rowOf(cell) : colOf(cell); }
+inline int indexOnLine(int cell, int direction) { return direction == EAST || direction == WEST ? colOf(cell) : rowOf(cell); }
+
+// distance map entry for cells the robot can never get to the target from
+const uint8_t UNREACHABLE_DISTANCE = 255;
+
 
 // utils
 
@@ -21,14 +34,53 @@ void insertInOrder(vector<int>* vec, int element);
 
 class DiagBarrier {
 	string color;
+	int robot; // index of the robot of that color, which passes straight through
 	bool direction; // true if forward, false is back
 
 public:
 
-	DiagBarrier(string color, bool direction) : color(color), direction(direction) {}
+	DiagBarrier(string color, bool direction) : color(color), robot(getRobotIndex(color)), direction(direction) {}
 	bool isForward() const;
 	bool isBackward() const;
 	const string& getColor() const;
+	int getRobot() const;
+};
+
+
+// set of cells on the board, one bit per cell
+struct Bitboard {
+
+	uint64_t words[NUM_CELLS / 64];
+
+	Bitboard() : words{0, 0, 0, 0} {}
+
+	void set(int cell) { this->words[cell >> 6] |= uint64_t(1) << (cell & 63); }
+	bool test(int cell) const { return (this->words[cell >> 6] >> (cell & 63)) & 1; }
+	bool any() const { return (this->words[0] | this->words[1] | this->words[2] | this->words[3]) != 0; }
+
+	Bitboard operator&(const Bitboard& other) const {
+		Bitboard result;
+		for (int i = 0; i < NUM_CELLS / 64; i++) {
+			result.words[i] = this->words[i] & other.words[i];
+		}
+		return result;
+	}
+
+	Bitboard& operator|=(const Bitboard& other) {
+		for (int i = 0; i < NUM_CELLS / 64; i++) {
+			this->words[i] |= other.words[i];
+		}
+		return *this;
+	}
+};
+
+
+// a slide that touches a diag, as it runs with no other robots on the board. its steps are the cells
+// it passes in order, with the above diag bit after each, so a robot on one of them stops the slide on the step before
+struct DiagPath {
+	Bitboard cells; // every cell passed, the start included
+	int first_step; // index of the first step in Board::diag_path_steps
+	int num_steps;
 };
 
 
@@ -38,11 +90,91 @@ class Board {
 	vector<vector<int>> col_barriers; // col_barriers[j] contains the row indices of each col barrier (horizontal) in row j
 	vector<vector<pair<int, DiagBarrier>>> diag_barriers; // diag_barriers[i][j] points to the diag barrier at position (i, j)
 
+	// compiled form of the barriers above, filled by compile()
+	bool compiled;
+	Bitboard walls[NUM_DIRECTIONS]; // walls[dir] has every cell with a barrier (or the board edge) on its dir side
+	Bitboard diag_cells; // every cell holding a diag barrier
+	Bitboard colored_diag_cells[NUM_ROBOTS_MAX]; // the diag cells each robot passes straight through
+	int interchangeable_robots[NUM_ROBOTS_MAX]; // per target robot, see getInterchangeableRobots
+	Bitboard slow_rays[NUM_DIRECTIONS]; // start cells whose ray in dir touches a diag, these use the slow path
+	uint8_t slow_directions[NUM_CELLS]; // per start cell, bit dir set if it is in slow_rays[dir]
+	Bitboard rays[NUM_DIRECTIONS][NUM_CELLS]; // cells passed over when sliding in dir from a cell, start excluded
+	uint8_t stop_cells[NUM_DIRECTIONS][NUM_CELLS]; // where a lone robot sliding in dir from a cell stops
+	uint16_t line_walls[NUM_DIRECTIONS][COMPILED_DIMENSION]; // per line, bit i set if cell i has a wall on its dir side
+	vector<int> diag_path_index; // per (start cell, dir, robot, above diag), index into diag_paths or -1 off slow_rays
+	vector<DiagPath> diag_paths;
+	vector<uint16_t> diag_path_steps; // cell << 1 | above diag
+	uint64_t fingerprint; // hash of the walls and diags
+
+	// single robot distance maps, built lazily and kept until the board is recompiled
+	mutable mutex distance_maps_mutex;
+	mutable vector<Bitboard> reach_tables[NUM_ROBOTS_MAX + 1]; // per robot, plus one shared by robots without diags
+	mutable map<int, vector<uint8_t>> distance_maps; // keyed by reach table * NUM_CELLS + dest cell
+
+	const vector<Bitboard>& getReachTable(int robot) const;
+	int reachTableIndex(int robot) const;
+
+	// the diag barrier at (row, col), NULL if there is none
+	const DiagBarrier* findDiagBarrier(int row, int col) const;
+
+	// the move kernel behind every uncompiled move, and behind the diag paths of compiled boards. slides the robot
+	// of index moving_robot in DIRECTION given every robot's row and col, following diag deflections into the next
+	// slide. leaves the robot's final square in rows and cols and its above diag bit in above_diag.
+	// if given, path gets a DiagPath step for every cell the slide passes
+	template <int DIRECTION>
+	void slide(int moving_robot, int* rows, int* cols, bool* above_diag, vector<uint16_t>* path=NULL) const;
+
+	// the diag path of a compiled board for the given start
+	const DiagPath& getDiagPath(int cell, int direction, int robot, bool above_diag) const;
+
+	// cell a robot on a slow ray stops on given the other robots in occupied, updating above_diag. compiled boards only
+	int diagSlideStop(int cell, int direction, int robot, bool* above_diag, const Bitboard& occupied) const;
+
+	// runs slide for a direction known only at run time, clearing the above diag bit if the robot stops off a diag.
+	// returns true if the robot's square or above diag bit changed
+	bool slideRobot(int direction, int moving_robot, int* rows, int* cols, bool* above_diag,
+		vector<uint16_t>* path=NULL) const;
+
+	// makeMove on a RobotArrangement through the move kernel
+	bool slowMove(int direction, int moving_robot, RobotArrangement* robot_positions) const;
+
 public:
 
 	// initializes vectors to the correct size
 	Board(int board_dimension=BOARD_DIMENSION);
 
+	// builds the wall bitboards and stop tables used by makeMove.
+	// must be called again after changing any barrier, the setters mark the board as not compiled
+	void compile();
+	bool isCompiled() const;
+
+	// every cell holding a diag barrier. read from the compiled tables, or from the barriers on an uncompiled board
+	Bitboard getDiagCells() const;
+
+	// the above diag bit the move kernel gives a robot of index robot that slides onto the diag cell moving in
+	// direction, coming from the next cell back. false if no slide enters the cell that way: it is on the board
+	// edge or behind a wall on that side, or that neighbor is a diag cell too
+	bool arrivalSide(int cell, int direction, int robot, bool* above_diag) const;
+
+	// hash of the compiled walls and diags, boards with the same barriers share a fingerprint
+	uint64_t getFingerprint() const;
+
+	// bitmask of the helper robots that can be swapped with each other without changing any search
+	// for dest_robot: the robots other than dest_robot with no diag of their own color on this board
+	// (diags are the only thing that tells robots apart). 0 when fewer than two qualify
+	int getInterchangeableRobots(int dest_robot) const;
+
+	// cell a robot starting at CELL stops on when sliding in DIRECTION, if the other robots on its line sit at
+	// the indexes set in LINE_OCCUPANCY (see lineOf and indexOnLine). one load of the line's walls and a bit scan.
+	// only valid on a compiled board, for start cells not in slow_rays
+	int slideStop(int cell, int direction, uint16_t line_occupancy) const;
+
+	// lower bound on the moves the given robot needs to get from each cell to dest_cell.
+	// built by a backward bfs that lets the robot stop anywhere along its path over the walls and diags,
+	// since other robots could be placed to stop it there. that relaxation keeps the bound admissible.
+	// cells that can never reach dest_cell hold UNREACHABLE_DISTANCE. cached on the board, safe across threads
+	const vector<uint8_t>& getDistanceMap(int dest_cell, int robot) const;
+
 	// returns whether there is a solution
 	// populates the solution vector with the series of moves it will take to move the MOVING_ROBOT to the DEST
 	bool solve(const RobotArrangement& robots, const Position& dest, const string& moving_robot, vector<Move>* solution, 
@@ -58,13 +190,28 @@ public:
 	void setColBarrier(int col, int row);
 	void setDiagBarrier(int row, int col, const string& color, bool is_forward);
 
+	// replaces every row and col barrier list at once. each list must already be sorted and hold the board edges
+	void setBarriers(const vector<vector<int>>& row_barriers, const vector<vector<int>>& col_barriers);
+
 
 	void display(const RobotArrangement& robots, const Position& dest) const;
 
+	// the above diag bit only matters for a robot on a diag cell, so moves clear it for every robot that stops
+	// anywhere else, and each board state has a single CompactArrangement key. this gives the arrangement
+	// that way, for starting arrangements that come from anywhere but a move
+	CompactArrangement normalized(const CompactArrangement& robot_positions) const;
+
 	// overwrites robot_positions with the results of making the given move on this board.
 	// returns true if the move actually did something
 	bool makeMove(Move move, RobotArrangement* robot_positions) const;
+	bool makeMove(Move move, CompactArrangement* robot_positions) const;
+
+	// makes every move at once, writing the arrangements that changed into children and their moves into child_moves,
+	// in all_moves order. gives the same children as calling makeMove with each move, and returns how many there are.
+	// rays without diags go through the slideLanes kernel (see successors.h), the rest through makeMove
+	int generateChildren(const CompactArrangement& robot_positions, CompactArrangement* children, Move* child_moves) const;
 
+	// single direction moves, always through the move kernel even on a compiled board
 	bool eastMove(const string& moving_robot_color, RobotArrangement* robot_positions) const;
 	bool westMove(const string& moving_robot_color, RobotArrangement* robot_positions) const;
 	bool northMove(const string& moving_robot_color, RobotArrangement* robot_positions) const;
@@ -77,4 +224,11 @@ public:
 
 };
 
+// checks of the move kernel on a hand built board, run by make test
+void testEastMove();
+void testWestMove();
+void testNortMove();
+void testSouthMove();
+void testCompiledMoves();
+
 #endif
\ No newline at end of file
@@ -0,0 +1,277 @@
+#include "cache.h"
+
+#include <iostream>
+#include <cstring>
+#include <cstddef>
+#include <type_traits>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+using namespace std;
+
+// address space reserved for the file up front, so growth never needs a remap. pages past the end of
+// the file are never touched
+static const size_t MAX_CACHE_BYTES = size_t(1) << 34;
+
+static const uint64_t CACHE_MAGIC = 0x4843414352434952; // "RICRCACH"
+static const uint32_t CACHE_VERSION = 1;
+
+struct CacheHeader {
+	uint64_t magic;
+	uint32_t version;
+	uint32_t record_size;
+	uint8_t reserved[48];
+};
+
+struct CacheRecord {
+	uint64_t board_fingerprint;
+	uint64_t robot_positions;
+	uint8_t dest_cell;
+	uint8_t dest_robot;
+	int8_t solution_length; // -1 if there is no solution shorter than max_depth
+	uint8_t max_depth;
+	uint32_t reserved;
+	uint8_t moves[MAX_CACHED_MOVES];
+	uint64_t checksum; // of everything above, a record that fails it is incomplete
+};
+
+static_assert(sizeof(CacheHeader) == 64, "cache header layout is part of the file format");
+static_assert(sizeof(CacheRecord) == 64, "cache record layout is part of the file format");
+static_assert(is_trivially_copyable<CacheRecord>::value, "cache records are copied straight to disk");
+
+
+static uint64_t recordChecksum(const CacheRecord& record) {
+	// fnv-1a, salted so an all zero record does not pass
+	const uint8_t* bytes = (const uint8_t*) &record;
+	uint64_t hash = 0xcbf29ce484222325;
+	for (size_t i = 0; i < offsetof(CacheRecord, checksum); i++) {
+		hash = (hash ^ bytes[i]) * 0x100000001b3;
+	}
+	return hash ^ CACHE_MAGIC;
+}
+
+static bool isComplete(const CacheRecord& record) {
+	return record.checksum == recordChecksum(record);
+}
+
+static CacheKey recordKey(const CacheRecord& record) {
+	return {record.board_fingerprint, record.robot_positions, record.dest_cell, record.dest_robot};
+}
+
+// a record with a solution answers every max_depth, one without only those up to the depth it searched
+static bool answers(const CacheRecord& record, int max_depth) {
+	return record.solution_length != -1 || record.max_depth >= max_depth;
+}
+
+static bool isBetter(const CacheRecord& record, const CacheRecord& current) {
+	return current.solution_length == -1 && (record.solution_length != -1 || record.max_depth > current.max_depth);
+}
+
+
+size_t CacheKeyHash::operator()(const CacheKey& key) const {
+	uint64_t hash = key.board_fingerprint ^ (key.robot_positions * 0x9e3779b97f4a7c15);
+	hash ^= uint64_t(key.dest_cell << 2 | key.dest_robot) * 0xc2b2ae3d27d4eb4f;
+	return hash ^ (hash >> 29);
+}
+
+
+SolutionCache::SolutionCache(const string& path, bool read_only) : num_hits(0), num_misses(0) {
+	this->mapping = NULL;
+	this->num_indexed_bytes = sizeof(CacheHeader);
+	this->read_only = read_only;
+	this->fd = open(path.c_str(), read_only ? O_RDONLY : O_RDWR | O_CREAT, 0644);
+	if (this->fd < 0) {
+		return;
+	}
+
+	// the first writer to find the file empty lays down the header
+	if (!read_only && flock(this->fd, LOCK_EX) == 0) {
+		struct stat file_stat;
+		if (fstat(this->fd, &file_stat) == 0 && file_stat.st_size == 0) {
+			CacheHeader header;
+			memset(&header, 0, sizeof(header));
+			header.magic = CACHE_MAGIC;
+			header.version = CACHE_VERSION;
+			header.record_size = sizeof(CacheRecord);
+			if (pwrite(this->fd, &header, sizeof(header), 0) != sizeof(header)) {
+				ftruncate(this->fd, 0);
+			}
+		}
+		flock(this->fd, LOCK_UN);
+	}
+
+	// leave files that are not caches of this version alone
+	CacheHeader header;
+	if (pread(this->fd, &header, sizeof(header), 0) != sizeof(header) || header.magic != CACHE_MAGIC ||
+		header.version != CACHE_VERSION || header.record_size != sizeof(CacheRecord)) {
+		close(this->fd);
+		this->fd = -1;
+		return;
+	}
+
+	void* mapping = mmap(NULL, MAX_CACHE_BYTES, PROT_READ, MAP_SHARED, this->fd, 0);
+	if (mapping == MAP_FAILED) {
+		close(this->fd);
+		this->fd = -1;
+		return;
+	}
+	this->mapping = (const uint8_t*) mapping;
+
+	lock_guard<mutex> lock(this->index_mutex);
+	this->refresh();
+}
+
+SolutionCache::~SolutionCache() {
+	if (this->mapping != NULL) {
+		munmap((void*) this->mapping, MAX_CACHE_BYTES);
+	}
+	if (this->fd >= 0) {
+		close(this->fd);
+	}
+}
+
+bool SolutionCache::isOpen() const {
+	return this->mapping != NULL;
+}
+
+
+// indexes the records appended since the last refresh, stopping at the first one still being written.
+// called with index_mutex held
+void SolutionCache::refresh() {
+	struct stat file_stat;
+	if (this->mapping == NULL || fstat(this->fd, &file_stat) != 0) {
+		return;
+	}
+
+	size_t file_size = min((size_t) file_stat.st_size, MAX_CACHE_BYTES);
+	while (this->num_indexed_bytes + sizeof(CacheRecord) <= file_size) {
+		const CacheRecord& record = *(const CacheRecord*) (this->mapping + this->num_indexed_bytes);
+		if (!isComplete(record)) {
+			break;
+		}
+		this->indexRecord(this->num_indexed_bytes);
+		this->num_indexed_bytes += sizeof(CacheRecord);
+	}
+}
+
+void SolutionCache::indexRecord(size_t offset) {
+	const CacheRecord& record = *(const CacheRecord*) (this->mapping + offset);
+	auto entry = this->index.insert(make_pair(recordKey(record), offset));
+	if (!entry.second && isBetter(record, *(const CacheRecord*) (this->mapping + entry.first->second))) {
+		entry.first->second = offset;
+	}
+}
+
+
+bool SolutionCache::lookup(const CacheKey& key, int max_depth, int* solution_length, vector<Move>* moves) {
+	ASSERT(solution_length != NULL, "cannot look up into a null length");
+	lock_guard<mutex> lock(this->index_mutex);
+
+	auto entry = this->index.find(key);
+	if (entry == this->index.end() || !answers(*(const CacheRecord*) (this->mapping + entry->second), max_depth)) {
+		// another process may have solved it since
+		this->refresh();
+		entry = this->index.find(key);
+	}
+	if (entry == this->index.end() || !answers(*(const CacheRecord*) (this->mapping + entry->second), max_depth)) {
+		this->num_misses++;
+		return false;
+	}
+
+	const CacheRecord& record = *(const CacheRecord*) (this->mapping + entry->second);
+	*solution_length = record.solution_length < max_depth ? record.solution_length : -1;
+	if (moves != NULL) {
+		moves->clear();
+		for (int i = 0; i < *solution_length; i++) {
+			moves->push_back(record.moves[i]);
+		}
+	}
+	this->num_hits++;
+	return true;
+}
+
+bool SolutionCache::store(const CacheKey& key, int max_depth, int solution_length, const vector<Move>& moves) {
+	if (this->mapping == NULL || this->read_only || solution_length > MAX_CACHED_MOVES) {
+		return false;
+	}
+	ASSERT(solution_length == -1 || (int) moves.size() == solution_length, "moves do not match the solution length");
+
+	CacheRecord record;
+	memset(&record, 0, sizeof(record));
+	record.board_fingerprint = key.board_fingerprint;
+	record.robot_positions = key.robot_positions;
+	record.dest_cell = key.dest_cell;
+	record.dest_robot = key.dest_robot;
+	record.solution_length = solution_length;
+	record.max_depth = min(max_depth, 255);
+	for (int i = 0; i < solution_length; i++) {
+		record.moves[i] = moves[i];
+	}
+	record.checksum = recordChecksum(record);
+
+	// appending without the lock could interleave with another writer
+	if (flock(this->fd, LOCK_EX) != 0) {
+		return false;
+	}
+	bool written = false;
+	struct stat file_stat;
+	if (fstat(this->fd, &file_stat) == 0 && (size_t) file_stat.st_size + sizeof(record) <= MAX_CACHE_BYTES) {
+		// append after the last whole record. holding the lock, an incomplete last record can only be left
+		// over from a writer that died, so it is overwritten
+		size_t num_records = (file_stat.st_size - sizeof(CacheHeader)) / sizeof(CacheRecord);
+		size_t offset = sizeof(CacheHeader) + num_records * sizeof(CacheRecord);
+		if (num_records > 0 && !isComplete(*(const CacheRecord*) (this->mapping + offset - sizeof(CacheRecord)))) {
+			offset -= sizeof(CacheRecord);
+		}
+		written = pwrite(this->fd, &record, sizeof(record), offset) == sizeof(record);
+	}
+	flock(this->fd, LOCK_UN);
+	if (!written) {
+		return false;
+	}
+
+	lock_guard<mutex> lock(this->index_mutex);
+	this->refresh();
+	return true;
+}
+
+
+long SolutionCache::getHits() const {
+	return this->num_hits;
+}
+
+long SolutionCache::getMisses() const {
+	return this->num_misses;
+}
+
+long SolutionCache::size() {
+	lock_guard<mutex> lock(this->index_mutex);
+	return this->index.size();
+}
+
+
+int solveRicochetBoardCached(SolutionCache* cache, const Board& board, const RobotArrangement& robot_positions,
+	const Position& dest, const string& dest_color, vector<Move>* moves, int max_depth) {
+
+	if (cache == NULL || !board.isCompiled()) {
+		return solveRicochetBoard(board, robot_positions, dest, dest_color, moves, max_depth);
+	}
+
+	CacheKey key = {board.getFingerprint(), board.normalized(CompactArrangement(robot_positions)).key(),
+		cellOf(dest.getRow(), dest.getCol()), getRobotIndex(dest_color)};
+	int solution_length;
+	if (cache->lookup(key, max_depth, &solution_length, moves)) {
+		return solution_length;
+	}
+
+	vector<Move> solution;
+	solution_length = solveRicochetBoard(board, robot_positions, dest, dest_color, &solution, max_depth);
+	cache->store(key, max_depth, solution_length, solution);
+	if (moves != NULL) {
+		*moves = solution;
+	}
+	return solution_length;
+}
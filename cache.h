@@ -0,0 +1,83 @@
+#ifndef CACHE_H
+#define CACHE_H
+
+#include "robots.h"
+#include "board.h"
+#include "solver.h"
+
+#include <atomic>
+#include <mutex>
+#include <unordered_map>
+
+using namespace std;
+
+// longest move list a cache record holds, longer solutions are solved every time
+const int MAX_CACHED_MOVES = 32;
+
+// a puzzle as the cache sees it: which board, where the robots start, and the target
+struct CacheKey {
+	uint64_t board_fingerprint;
+	uint64_t robot_positions; // CompactArrangement key
+	int dest_cell;
+	int dest_robot;
+
+	bool operator==(const CacheKey& other) const {
+		return this->board_fingerprint == other.board_fingerprint && this->robot_positions == other.robot_positions &&
+			this->dest_cell == other.dest_cell && this->dest_robot == other.dest_robot;
+	}
+};
+
+struct CacheKeyHash {
+	size_t operator()(const CacheKey& key) const;
+};
+
+// solved puzzles kept in an append only file, shared by every process (and thread) that opens it.
+// the file is a header followed by fixed size checksummed records. it is mapped read only, and records
+// appended by anyone are picked up the next time a lookup misses. writers append under an exclusive flock,
+// readers never lock: a record still being written fails its checksum and is skipped until it is complete.
+// searches that found nothing are stored too, with the depth they gave up at
+class SolutionCache {
+
+	int fd;
+	const uint8_t* mapping; // NULL if the file could not be opened or mapped, then every lookup misses
+	size_t num_indexed_bytes; // prefix of the file already in the index
+	unordered_map<CacheKey, size_t, CacheKeyHash> index; // offset of the best record for each puzzle
+	mutex index_mutex;
+	bool read_only;
+
+	atomic<long> num_hits;
+	atomic<long> num_misses;
+
+	void refresh();
+	void indexRecord(size_t offset);
+
+public:
+
+	// creates the file if needed, unless read_only
+	SolutionCache(const string& path, bool read_only=false);
+	~SolutionCache();
+	SolutionCache(const SolutionCache&) = delete;
+	SolutionCache& operator=(const SolutionCache&) = delete;
+
+	bool isOpen() const;
+
+	// returns true on a hit, with the stored length in *solution_length (-1 if no solution is shorter than max_depth)
+	// and the stored moves in *moves
+	bool lookup(const CacheKey& key, int max_depth, int* solution_length, vector<Move>* moves);
+
+	// appends the result of a search that looked at every depth below max_depth. returns false if it was not
+	// written: the cache is closed or read only, the solution is too long, or locking or writing the file failed
+	bool store(const CacheKey& key, int max_depth, int solution_length, const vector<Move>& moves);
+
+	long getHits() const;
+	long getMisses() const;
+
+	// number of distinct puzzles in the file, as of the last refresh
+	long size();
+};
+
+// solveRicochetBoard behind a cache: repeat puzzles come back with the stored moves without searching
+int solveRicochetBoardCached(SolutionCache* cache, const Board& board, const RobotArrangement& robot_positions,
+	const Position& dest, const string& dest_color, vector<Move>* moves, int max_depth=DEFAULT_MAX_DEPTH);
+
+#endif
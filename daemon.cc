@@ -0,0 +1,380 @@
+#include "daemon.h"
+#include "batch.h"
+#include "quadrant.h"
+
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <cerrno>
+#include <deque>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <type_traits>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/un.h>
+
+using namespace std;
+
+int DAEMON_CLIENT_WINDOW = 64;
+int DAEMON_WORKER_THREADS = 0;
+int DAEMON_MAX_BOARDS = 256;
+
+// requests read off the sockets ahead of the workers. readers wait once this many are queued
+static const size_t DAEMON_QUEUE_CAPACITY = 1024;
+
+// a response that cannot be written for this long means the client stopped reading, and it is dropped
+static const int DAEMON_SEND_TIMEOUT_SECONDS = 10;
+
+// how long accept backs off when the daemon is out of descriptors or memory
+static const int ACCEPT_BACKOFF_MILLIS = 50;
+
+static_assert(sizeof(DaemonRequest) == 24, "request layout is part of the protocol");
+static_assert(sizeof(DaemonResponse) == 48, "response layout is part of the protocol");
+static_assert(is_trivially_copyable<DaemonRequest>::value && is_trivially_copyable<DaemonResponse>::value,
+	"frames are copied straight to the socket");
+
+
+// false if the peer went away before the whole frame came through
+static bool readFrame(int fd, void* frame, size_t size) {
+	char* bytes = (char*) frame;
+	while (size > 0) {
+		ssize_t num_read = read(fd, bytes, size);
+		if (num_read <= 0) {
+			return false;
+		}
+		bytes += num_read;
+		size -= num_read;
+	}
+	return true;
+}
+
+static bool writeFrame(int fd, const void* frame, size_t size) {
+	const char* bytes = (const char*) frame;
+	while (size > 0) {
+		// a client that hung up must not take the daemon down with a SIGPIPE
+		ssize_t num_written = ::send(fd, bytes, size, MSG_NOSIGNAL);
+		if (num_written <= 0) {
+			return false;
+		}
+		bytes += num_written;
+		size -= num_written;
+	}
+	return true;
+}
+
+static bool socketAddress(const string& socket_path, sockaddr_un* address) {
+	memset(address, 0, sizeof(*address));
+	address->sun_family = AF_UNIX;
+	if (socket_path.size() >= sizeof(address->sun_path)) {
+		return false;
+	}
+	strcpy(address->sun_path, socket_path.c_str());
+	return true;
+}
+
+
+static bool isValid(const DaemonRequest& request) {
+	for (int i = 0; i < 4; i++) {
+		if (request.layout[i] < 1 || request.layout[i] > NUM_QUADRANTS) {
+			return false;
+		}
+	}
+	CompactArrangement robot_positions = CompactArrangement::fromKey(request.robot_positions);
+	for (int robot = 0; robot < NUM_ROBOTS; robot++) {
+		for (int other = 0; other < robot; other++) {
+			if (robot_positions.getCell(robot) == robot_positions.getCell(other)) {
+				return false;
+			}
+		}
+	}
+	return request.robot_positions >> (4 + 8 * NUM_ROBOTS) == 0 && request.dest_robot < NUM_ROBOTS &&
+		request.algorithm <= PARALLEL_BREADTH_FIRST && request.max_depth <= MAX_DAEMON_MOVES + 1;
+}
+
+static DaemonResponse answer(const DaemonRequest& request, BoardCache* boards, SolutionCache* cache) {
+	chrono::steady_clock::time_point start = chrono::steady_clock::now();
+	DaemonResponse response;
+	memset(&response, 0, sizeof(response));
+	response.request_id = request.request_id;
+	response.solution_length = DAEMON_BAD_REQUEST;
+	if (!isValid(request)) {
+		return response;
+	}
+
+	shared_ptr<const Board> board_ref =
+		boards->getBoard({request.layout[0], request.layout[1], request.layout[2], request.layout[3]});
+	const Board& board = *board_ref;
+	CompactArrangement robot_positions = board.normalized(CompactArrangement::fromKey(request.robot_positions));
+	Position dest(rowOf(request.dest_cell), colOf(request.dest_cell));
+	int max_depth = request.max_depth == 0 ? min(DEFAULT_MAX_DEPTH, MAX_DAEMON_MOVES + 1) : request.max_depth;
+	CacheKey key = {board.getFingerprint(), robot_positions.key(), request.dest_cell, request.dest_robot};
+
+	vector<vector<Move>> solutions(1);
+	int solution_length;
+	if (cache == NULL || !cache->lookup(key, max_depth, &solution_length, &solutions[0])) {
+		solutions.clear();
+		solution_length = solveRicochetBoard(board, robot_positions.toRobotArrangement(), dest,
+			all_colors[request.dest_robot], &solutions, 1, SearchAlgorithm(request.algorithm), max_depth);
+		if (cache != NULL) {
+			cache->store(key, max_depth, solution_length, solutions.empty() ? vector<Move>() : solutions[0]);
+		}
+	}
+
+	response.solution_length = solution_length;
+	if (!solutions.empty()) {
+		response.num_moves = solutions[0].size();
+		for (size_t i = 0; i < solutions[0].size(); i++) {
+			response.moves[i] = solutions[0][i];
+		}
+	}
+	response.micros = chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - start).count();
+	return response;
+}
+
+// one client connection, shared by the thread reading its requests and the workers answering them.
+// the socket is closed once the last of them lets go
+struct DaemonConnection {
+	int fd;
+	mutex write_mutex; // workers finishing at once must not interleave their responses
+	atomic<bool> broken; // a write failed, the client is gone or stopped reading
+
+	DaemonConnection(int fd) : fd(fd), broken(false) {}
+	~DaemonConnection() {
+		close(this->fd);
+	}
+};
+
+struct DaemonJob {
+	shared_ptr<DaemonConnection> connection;
+	DaemonRequest request;
+};
+
+// hands every request on the connection to the workers, until the client hangs up
+static void readRequests(shared_ptr<DaemonConnection> connection, BoundedQueue<DaemonJob>* jobs) {
+	DaemonRequest request;
+	while (!connection->broken && readFrame(connection->fd, &request, sizeof(request))) {
+		jobs->push({connection, request});
+	}
+}
+
+// answers requests from every connection, writing each response as soon as it is ready
+static void answerRequests(BoundedQueue<DaemonJob>* jobs, BoardCache* boards, SolutionCache* cache) {
+	DaemonJob job;
+	while (jobs->pop(&job)) {
+		if (job.connection->broken) {
+			continue;
+		}
+		DaemonResponse response = answer(job.request, boards, cache);
+		lock_guard<mutex> lock(job.connection->write_mutex);
+		if (!writeFrame(job.connection->fd, &response, sizeof(response))) {
+			job.connection->broken = true;
+		}
+		// lets go of the connection before waiting for the next job, so a finished one closes promptly
+		job = DaemonJob();
+	}
+}
+
+void runSolverDaemon(const string& socket_path, SolutionCache* cache) {
+	sockaddr_un address;
+	bool addressable = socketAddress(socket_path, &address);
+	ASSERT(addressable, "socket path " << socket_path << " is too long");
+	int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+	ASSERT(listener >= 0, "cannot create a unix socket");
+	// replaces a socket left behind by an earlier daemon, never anything else at the path
+	struct stat existing;
+	if (lstat(socket_path.c_str(), &existing) == 0) {
+		ASSERT(S_ISSOCK(existing.st_mode), socket_path << " exists and is not a socket");
+		unlink(socket_path.c_str());
+	}
+	int bound = bind(listener, (sockaddr*) &address, sizeof(address));
+	ASSERT(bound == 0, "cannot bind " << socket_path);
+	int listening = listen(listener, SOMAXCONN);
+	ASSERT(listening == 0, "cannot listen on " << socket_path);
+
+	// shared by every connection, so a layout is compiled once while it stays in use
+	BoardCache boards(DAEMON_MAX_BOARDS);
+	BoundedQueue<DaemonJob> jobs(DAEMON_QUEUE_CAPACITY);
+	int num_workers = DAEMON_WORKER_THREADS > 0 ? DAEMON_WORKER_THREADS : max(1u, thread::hardware_concurrency());
+	for (int worker = 0; worker < num_workers; worker++) {
+		thread(answerRequests, &jobs, &boards, cache).detach();
+	}
+
+	timeval send_timeout = {DAEMON_SEND_TIMEOUT_SECONDS, 0};
+	while (true) {
+		int fd = accept(listener, NULL, NULL);
+		if (fd < 0) {
+			// out of descriptors or memory: wait for connections to close rather than spin on the error
+			bool out_of_resources = errno == EMFILE || errno == ENFILE || errno == ENOBUFS || errno == ENOMEM;
+			bool transient = errno == EINTR || errno == ECONNABORTED || errno == EPROTO || errno == EAGAIN;
+			ASSERT(out_of_resources || transient, "cannot accept on " << socket_path << ": " << strerror(errno));
+			if (out_of_resources) {
+				this_thread::sleep_for(chrono::milliseconds(ACCEPT_BACKOFF_MILLIS));
+			}
+			continue;
+		}
+		setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &send_timeout, sizeof(send_timeout));
+		thread(readRequests, make_shared<DaemonConnection>(fd), &jobs).detach();
+	}
+}
+
+
+DaemonClient::DaemonClient(const string& socket_path) {
+	sockaddr_un address;
+	this->fd = socketAddress(socket_path, &address) ? socket(AF_UNIX, SOCK_STREAM, 0) : -1;
+	if (this->fd >= 0 && connect(this->fd, (sockaddr*) &address, sizeof(address)) != 0) {
+		close(this->fd);
+		this->fd = -1;
+	}
+}
+
+DaemonClient::~DaemonClient() {
+	if (this->fd >= 0) {
+		close(this->fd);
+	}
+}
+
+bool DaemonClient::isOpen() const {
+	return this->fd >= 0;
+}
+
+bool DaemonClient::send(const DaemonRequest& request) {
+	return this->fd >= 0 && writeFrame(this->fd, &request, sizeof(request));
+}
+
+bool DaemonClient::receive(DaemonResponse* response) {
+	return this->fd >= 0 && readFrame(this->fd, response, sizeof(*response));
+}
+
+
+// a puzzle line the client has read, sent unless it failed to parse
+struct ClientPuzzle {
+	int line_num;
+	string error; // set for lines that were never sent
+	uint32_t request_id;
+	chrono::steady_clock::time_point sent;
+	bool answered;
+	DaemonResponse response;
+	double millis; // round trip, once answered
+};
+
+// writes the result line of an answered puzzle, returns false if the daemon rejected it
+static bool writeResult(ostream& out, const ClientPuzzle& puzzle) {
+	const DaemonResponse& response = puzzle.response;
+	if (response.solution_length == DAEMON_BAD_REQUEST) {
+		out << puzzle.line_num << " error rejected by the daemon\n";
+		return false;
+	}
+	out << puzzle.line_num << " " << int(response.solution_length) << " " << fixed << setprecision(3) << puzzle.millis;
+	for (int i = 0; i < response.num_moves; i++) {
+		out << " " << getColor(response.moves[i]) << "," << getDirection(response.moves[i]);
+	}
+	out << "\n";
+	return true;
+}
+
+int runDaemonClient(istream& in, ostream& out, const string& socket_path, SearchAlgorithm algorithm, int max_depth) {
+	ASSERT(max_depth <= MAX_DAEMON_MOVES + 1, "the daemon searches at most " << MAX_DAEMON_MOVES + 1 << " deep");
+	DaemonClient client(socket_path);
+	ASSERT(client.isOpen(), "cannot connect to " << socket_path);
+
+	// responses come back as the daemon's workers finish them, so they are matched to the window by request id,
+	// and results are written once everything ahead of them is answered
+	deque<ClientPuzzle> window;
+	vector<double> latencies; // round trips, from sending a request to its response
+	vector<double> solve_latencies; // time spent in the daemon
+	int num_errors = 0;
+	uint32_t next_request_id = 0;
+	chrono::steady_clock::time_point start = chrono::steady_clock::now();
+
+	string line;
+	int line_num = 0;
+	bool more_input = true;
+	while (more_input || !window.empty()) {
+		while (more_input && int(window.size()) < DAEMON_CLIENT_WINDOW) {
+			if (!getline(in, line)) {
+				more_input = false;
+				break;
+			}
+			line_num++;
+			size_t first = line.find_first_not_of(" \t\r");
+			if (first == string::npos || line[first] == '#') {
+				continue;
+			}
+
+			BatchPuzzle puzzle;
+			ClientPuzzle client_puzzle;
+			client_puzzle.line_num = line_num;
+			client_puzzle.answered = false;
+			if (!parseBatchPuzzle(line, line_num, &puzzle)) {
+				client_puzzle.error = puzzle.error;
+				window.push_back(client_puzzle);
+				continue;
+			}
+			DaemonRequest request;
+			memset(&request, 0, sizeof(request));
+			request.request_id = next_request_id++;
+			for (int i = 0; i < 4; i++) {
+				request.layout[i] = puzzle.layout[i];
+			}
+			request.robot_positions = puzzle.robot_positions.key();
+			request.dest_cell = puzzle.dest_cell;
+			request.dest_robot = puzzle.dest_robot;
+			request.algorithm = algorithm;
+			request.max_depth = max_depth;
+			bool sent = client.send(request);
+			ASSERT(sent, "lost the connection to " << socket_path);
+			client_puzzle.request_id = request.request_id;
+			client_puzzle.sent = chrono::steady_clock::now();
+			window.push_back(client_puzzle);
+		}
+
+		// write out everything at the front that is settled
+		while (!window.empty() && (!window.front().error.empty() || window.front().answered)) {
+			const ClientPuzzle& puzzle = window.front();
+			if (!puzzle.error.empty()) {
+				out << puzzle.line_num << " error " << puzzle.error << "\n";
+				num_errors++;
+			} else if (!writeResult(out, puzzle)) {
+				num_errors++;
+			}
+			window.pop_front();
+		}
+		if (window.empty()) {
+			continue;
+		}
+
+		DaemonResponse response;
+		bool received = client.receive(&response);
+		ASSERT(received, "lost the connection to " << socket_path);
+		chrono::steady_clock::time_point now = chrono::steady_clock::now();
+		auto puzzle = find_if(window.begin(), window.end(), [&](const ClientPuzzle& puzzle) {
+			return puzzle.error.empty() && !puzzle.answered && puzzle.request_id == response.request_id;
+		});
+		ASSERT(puzzle != window.end(), "the daemon answered request " << response.request_id << ", which is not in flight");
+		double millis = chrono::duration<double, milli>(now - puzzle->sent).count();
+		latencies.push_back(millis);
+		solve_latencies.push_back(response.micros / 1000.0);
+		puzzle->answered = true;
+		puzzle->response = response;
+		puzzle->millis = millis;
+	}
+	out.flush();
+
+	double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+	sort(latencies.begin(), latencies.end());
+	sort(solve_latencies.begin(), solve_latencies.end());
+	if (!latencies.empty()) {
+		size_t p50 = latencies.size() / 2;
+		size_t p99 = latencies.size() * 99 / 100;
+		cerr << latencies.size() << " requests in " << seconds << " s, " << latencies.size() / seconds << " per second, "
+			<< "round trip p50 " << latencies[p50] << " ms, p99 " << latencies[p99] << " ms, max " << latencies.back()
+			<< " ms, in the daemon p50 " << solve_latencies[p50] << " ms, p99 " << solve_latencies[p99] << " ms" << endl;
+	}
+	return num_errors;
+}
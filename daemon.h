@@ -0,0 +1,84 @@
+#ifndef DAEMON_H
+#define DAEMON_H
+
+#include "robots.h"
+#include "solver.h"
+#include "cache.h"
+
+#include <istream>
+#include <ostream>
+
+using namespace std;
+
+// longest solution a response carries, requests cannot ask for deeper searches
+const int MAX_DAEMON_MOVES = 32;
+
+// requests a client keeps on the socket before waiting for a response
+extern int DAEMON_CLIENT_WINDOW;
+
+// threads the daemon solves on, 0 for one per hardware thread
+extern int DAEMON_WORKER_THREADS;
+
+// compiled boards the daemon keeps, the least recently used goes first. each holds its tables and distance maps
+extern int DAEMON_MAX_BOARDS;
+
+// one solve, sent over the socket as these bytes
+struct DaemonRequest {
+	uint32_t request_id; // echoed in the response
+	uint8_t layout[4]; // quadrant numbers as in buildBoard
+	uint64_t robot_positions; // CompactArrangement key
+	uint8_t dest_cell;
+	uint8_t dest_robot;
+	uint8_t algorithm; // a SearchAlgorithm
+	uint8_t max_depth; // 0 for DEFAULT_MAX_DEPTH
+	uint32_t reserved;
+};
+
+// solution_length of a response to a request that does not describe a puzzle
+const int8_t DAEMON_BAD_REQUEST = -2;
+
+struct DaemonResponse {
+	uint32_t request_id;
+	int8_t solution_length; // -1 if there is no solution shorter than max_depth, or DAEMON_BAD_REQUEST
+	uint8_t num_moves;
+	uint16_t reserved;
+	uint32_t micros; // time the daemon spent on the request
+	uint32_t reserved2;
+	uint8_t moves[MAX_DAEMON_MOVES];
+};
+
+// serves requests on a unix domain socket at socket_path until the process is killed, replacing a socket
+// already there (and stopping if anything else is). every connection gets a thread that reads its requests onto
+// a queue shared by DAEMON_WORKER_THREADS solvers, so one connection's requests are solved in parallel and
+// answered out of order, one response each, matched by request_id. when out of file descriptors it waits and
+// keeps accepting. boards are compiled once per quadrant layout and kept, with their distance maps, up to
+// DAEMON_MAX_BOARDS of them. with a cache, puzzles are looked up in it first and new solutions are added to it
+void runSolverDaemon(const string& socket_path, SolutionCache* cache=NULL);
+
+// one connection to a daemon
+class DaemonClient {
+
+	int fd; // -1 if the connection failed or broke
+
+public:
+
+	DaemonClient(const string& socket_path);
+	~DaemonClient();
+	DaemonClient(const DaemonClient&) = delete;
+	DaemonClient& operator=(const DaemonClient&) = delete;
+
+	bool isOpen() const;
+
+	// whole frames only, false once the connection is gone
+	bool send(const DaemonRequest& request);
+	bool receive(DaemonResponse* response);
+};
+
+// sends every puzzle read from in, in the --batch format, to the daemon at socket_path with up to
+// DAEMON_CLIENT_WINDOW of them in flight. writes one line per puzzle like solveBatch, with the round trip
+// in place of the solve time, and the throughput and latency percentiles to stderr.
+// returns the number of puzzles that did not parse or were rejected
+int runDaemonClient(istream& in, ostream& out, const string& socket_path, SearchAlgorithm algorithm=ITERATIVE_DEEPENING,
+	int max_depth=DEFAULT_MAX_DEPTH);
+
+#endif
@@ -0,0 +1,453 @@
+#include "external.h"
+
+#include <iostream>
+#include <algorithm>
+#include <queue>
+#include <memory>
+#include <chrono>
+#include <cstdio>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+using namespace std;
+
+size_t DEFAULT_EXTERNAL_BUFFER_BYTES = size_t(1) << 28;
+
+// keys moved by each read or write of a layer or run file
+static const size_t IO_BUFFER_KEYS = 8192;
+
+static const uint64_t PROGRESS_MAGIC = 0x4642545845434952; // "RICEXTBF"
+static const uint32_t PROGRESS_VERSION = 1;
+
+// what a work_dir holds: which puzzle, and how many of its layers are finished
+struct ExternalProgress {
+	uint64_t magic;
+	uint32_t version;
+	uint32_t num_layers;
+	uint64_t board_fingerprint;
+	uint64_t start; // canonical key of the start, the only key in layer 0
+	uint32_t dest_cell;
+	uint32_t dest_robot;
+};
+
+static_assert(sizeof(ExternalProgress) == 40, "progress layout is part of the file format");
+
+
+static string layerPath(const string& work_dir, int depth) {
+	return work_dir + "/layer_" + to_string(depth);
+}
+
+static string runPath(const string& work_dir, int depth, int run) {
+	return layerPath(work_dir, depth) + ".run_" + to_string(run);
+}
+
+static string progressPath(const string& work_dir) {
+	return work_dir + "/progress";
+}
+
+// number of keys in a finished layer or run file
+static long numKeys(const string& path) {
+	struct stat file_stat;
+	int result = stat(path.c_str(), &file_stat);
+	ASSERT(result == 0, "cannot stat " << path);
+	return file_stat.st_size / sizeof(uint64_t);
+}
+
+
+// streams the keys of a layer or run file in order
+class KeyReader {
+
+	string path;
+	int fd;
+	vector<uint64_t> buffer;
+	size_t next;
+	size_t end;
+
+public:
+
+	KeyReader(const string& path) : path(path), buffer(IO_BUFFER_KEYS), next(0), end(0) {
+		this->fd = open(path.c_str(), O_RDONLY);
+		ASSERT(this->fd >= 0, "cannot open " << path);
+	}
+
+	~KeyReader() {
+		close(this->fd);
+	}
+
+	KeyReader(const KeyReader&) = delete;
+	KeyReader& operator=(const KeyReader&) = delete;
+
+	// true once every key has been popped, reads the next block when the buffered one runs out
+	bool empty() {
+		if (this->next < this->end) {
+			return false;
+		}
+		size_t num_bytes = 0;
+		size_t capacity = this->buffer.size() * sizeof(uint64_t);
+		while (num_bytes < capacity) {
+			ssize_t num_read = read(this->fd, (char*) this->buffer.data() + num_bytes, capacity - num_bytes);
+			ASSERT(num_read >= 0, "cannot read " << this->path);
+			if (num_read == 0) {
+				break;
+			}
+			num_bytes += num_read;
+		}
+		ASSERT(num_bytes % sizeof(uint64_t) == 0, this->path << " ends in a partial key");
+		this->next = 0;
+		this->end = num_bytes / sizeof(uint64_t);
+		return this->end == 0;
+	}
+
+	uint64_t front() const {
+		return this->buffer[this->next];
+	}
+
+	void pop() {
+		this->next++;
+	}
+};
+
+// writes keys to a new file, which is only complete on disk once finish returns
+class KeyWriter {
+
+	string path;
+	int fd;
+	vector<uint64_t> buffer;
+	long num_keys;
+
+	void flush() {
+		const char* bytes = (const char*) this->buffer.data();
+		size_t num_bytes = this->buffer.size() * sizeof(uint64_t);
+		while (num_bytes > 0) {
+			ssize_t num_written = write(this->fd, bytes, num_bytes);
+			ASSERT(num_written > 0, "cannot write " << this->path);
+			bytes += num_written;
+			num_bytes -= num_written;
+		}
+		this->buffer.clear();
+	}
+
+public:
+
+	KeyWriter(const string& path) : path(path), num_keys(0) {
+		this->fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+		ASSERT(this->fd >= 0, "cannot create " << path);
+		this->buffer.reserve(IO_BUFFER_KEYS);
+	}
+
+	~KeyWriter() {
+		if (this->fd >= 0) {
+			close(this->fd);
+		}
+	}
+
+	KeyWriter(const KeyWriter&) = delete;
+	KeyWriter& operator=(const KeyWriter&) = delete;
+
+	void push(uint64_t key) {
+		this->buffer.push_back(key);
+		this->num_keys++;
+		if (this->buffer.size() == IO_BUFFER_KEYS) {
+			this->flush();
+		}
+	}
+
+	// flushes and syncs the file, returns the number of keys written
+	long finish() {
+		this->flush();
+		int result = fsync(this->fd);
+		ASSERT(result == 0, "cannot sync " << this->path);
+		close(this->fd);
+		this->fd = -1;
+		return this->num_keys;
+	}
+};
+
+
+// layers finished for this puzzle in work_dir, 0 if there are none or they belong to another puzzle
+static int readProgress(const string& work_dir, const ExternalProgress& puzzle) {
+	ExternalProgress progress;
+	int fd = open(progressPath(work_dir).c_str(), O_RDONLY);
+	if (fd < 0) {
+		return 0;
+	}
+	bool complete = read(fd, &progress, sizeof(progress)) == sizeof(progress);
+	close(fd);
+
+	bool same_puzzle = complete && progress.magic == PROGRESS_MAGIC && progress.version == PROGRESS_VERSION &&
+		progress.board_fingerprint == puzzle.board_fingerprint && progress.start == puzzle.start &&
+		progress.dest_cell == puzzle.dest_cell && progress.dest_robot == puzzle.dest_robot;
+	return same_puzzle ? progress.num_layers : 0;
+}
+
+// replaces the progress file in one rename, so a crash leaves either the old or the new one
+static void writeProgress(const string& work_dir, const ExternalProgress& progress) {
+	string partial_path = progressPath(work_dir) + ".partial";
+	int fd = open(partial_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	ASSERT(fd >= 0, "cannot create " << partial_path);
+	bool written = write(fd, &progress, sizeof(progress)) == sizeof(progress) && fsync(fd) == 0;
+	close(fd);
+	ASSERT(written, "cannot write " << partial_path);
+	int result = rename(partial_path.c_str(), progressPath(work_dir).c_str());
+	ASSERT(result == 0, "cannot rename " << partial_path);
+}
+
+
+// sorts the buffered children and writes them out as the next run, without duplicates
+static void writeRun(const string& work_dir, int depth, int run, vector<uint64_t>* children) {
+	sort(children->begin(), children->end());
+	KeyWriter writer(runPath(work_dir, depth, run));
+	for (size_t i = 0; i < children->size(); i++) {
+		if (i == 0 || (*children)[i] != (*children)[i - 1]) {
+			writer.push((*children)[i]);
+		}
+	}
+	writer.finish();
+	children->clear();
+}
+
+// expands the layer at depth into sorted runs of the canonical keys of its children, and returns the number
+// of runs. stops as soon as a child lands on dest, with its parent's key in *solution
+static int expandLayer(const Board& board, const string& work_dir, int depth, int dest_cell, int dest_robot,
+	size_t buffer_keys, bool* solved, uint64_t* solution, DepthStats* stats) {
+
+	int interchangeable_robots = board.getInterchangeableRobots(dest_robot);
+	vector<uint64_t> children_keys;
+	children_keys.reserve(buffer_keys);
+	int num_runs = 0;
+
+	*solved = false;
+	KeyReader layer(layerPath(work_dir, depth));
+	for (; !layer.empty(); layer.pop()) {
+		CompactArrangement children[NUM_MOVES];
+		Move child_moves[NUM_MOVES];
+		int num_children = board.generateChildren(CompactArrangement::fromKey(layer.front()), children, child_moves);
+		if (stats != NULL) {
+			stats->nodes_expanded++;
+			stats->nodes_generated += num_children;
+		}
+
+		if (children_keys.size() + num_children > buffer_keys) {
+			writeRun(work_dir, depth + 1, num_runs++, &children_keys);
+		}
+		for (int child = 0; child < num_children; child++) {
+			if (children[child].isSolution(dest_cell, dest_robot)) {
+				*solved = true;
+				*solution = layer.front();
+				return num_runs;
+			}
+			children_keys.push_back(children[child].canonical(interchangeable_robots).key());
+		}
+	}
+
+	if (!children_keys.empty()) {
+		writeRun(work_dir, depth + 1, num_runs++, &children_keys);
+	}
+	return num_runs;
+}
+
+// merges the runs of the layer after depth into that layer, dropping every key that is in any layer up to depth.
+// moves cannot be undone, so a state can come back many layers after it was first reached, and checking
+// only the last two layers would let it through to be expanded again. the layer is written under a temporary
+// name and renamed into place once complete. returns the number of keys in it
+static long mergeRuns(const string& work_dir, int depth, int num_runs) {
+	typedef pair<uint64_t, int> HeapEntry; // key and the run it came from
+	priority_queue<HeapEntry, vector<HeapEntry>, greater<HeapEntry>> heap;
+	vector<unique_ptr<KeyReader>> runs;
+	for (int run = 0; run < num_runs; run++) {
+		runs.emplace_back(new KeyReader(runPath(work_dir, depth + 1, run)));
+		if (!runs[run]->empty()) {
+			heap.push(make_pair(runs[run]->front(), run));
+		}
+	}
+
+	vector<unique_ptr<KeyReader>> previous_layers;
+	for (int previous = depth; previous >= 0; previous--) {
+		previous_layers.emplace_back(new KeyReader(layerPath(work_dir, previous)));
+	}
+
+	string partial_path = layerPath(work_dir, depth + 1) + ".partial";
+	KeyWriter layer(partial_path);
+	bool any_written = false;
+	uint64_t last_key = 0;
+	while (!heap.empty()) {
+		uint64_t key = heap.top().first;
+		int run = heap.top().second;
+		heap.pop();
+		runs[run]->pop();
+		if (!runs[run]->empty()) {
+			heap.push(make_pair(runs[run]->front(), run));
+		}
+
+		// the same key from another run
+		if (any_written && key == last_key) {
+			continue;
+		}
+		any_written = true;
+		last_key = key;
+
+		// every file is sorted, so the previous layers only ever move forward. the layers are disjoint, so
+		// the first one holding the key settles it
+		bool seen = false;
+		for (size_t previous = 0; previous < previous_layers.size() && !seen; previous++) {
+			KeyReader& previous_layer = *previous_layers[previous];
+			while (!previous_layer.empty() && previous_layer.front() < key) {
+				previous_layer.pop();
+			}
+			seen = !previous_layer.empty() && previous_layer.front() == key;
+		}
+		if (!seen) {
+			layer.push(key);
+		}
+	}
+
+	long num_keys = layer.finish();
+	int result = rename(partial_path.c_str(), layerPath(work_dir, depth + 1).c_str());
+	ASSERT(result == 0, "cannot rename " << partial_path);
+	for (int run = 0; run < num_runs; run++) {
+		unlink(runPath(work_dir, depth + 1, run).c_str());
+	}
+	return num_keys;
+}
+
+
+// a key in the layer at depth with a child whose canonical key is child_key
+static uint64_t findParent(const Board& board, const string& work_dir, int depth, uint64_t child_key,
+	int interchangeable_robots) {
+
+	KeyReader layer(layerPath(work_dir, depth));
+	for (; !layer.empty(); layer.pop()) {
+		CompactArrangement children[NUM_MOVES];
+		Move child_moves[NUM_MOVES];
+		int num_children = board.generateChildren(CompactArrangement::fromKey(layer.front()), children, child_moves);
+		for (int child = 0; child < num_children; child++) {
+			if (children[child].canonical(interchangeable_robots).key() == child_key) {
+				return layer.front();
+			}
+		}
+	}
+	ASSERT(false, layerPath(work_dir, depth) << " holds no parent of a state in the layer after it");
+	return 0;
+}
+
+// rebuilds the moves of a solution whose last move is made from the state with canonical key solution
+// in the layer at depth. the layers hold canonical keys, so the chain of states is found backwards through them,
+// and the moves are then replayed forwards from the real start, following the chain up to helper swaps
+static void rebuildMoves(const Board& board, const string& work_dir, const CompactArrangement& start, int depth,
+	uint64_t solution, int dest_cell, int dest_robot, vector<Move>* moves) {
+
+	int interchangeable_robots = board.getInterchangeableRobots(dest_robot);
+	vector<uint64_t> chain(depth + 1);
+	chain[depth] = solution;
+	for (int previous = depth - 1; previous >= 0; previous--) {
+		chain[previous] = findParent(board, work_dir, previous, chain[previous + 1], interchangeable_robots);
+	}
+
+	CompactArrangement robot_positions = start;
+	for (int step = 1; step <= depth + 1; step++) {
+		CompactArrangement children[NUM_MOVES];
+		Move child_moves[NUM_MOVES];
+		int num_children = board.generateChildren(robot_positions, children, child_moves);
+		int next = -1;
+		for (int child = 0; child < num_children && next == -1; child++) {
+			bool on_chain = step <= depth ?
+				children[child].canonical(interchangeable_robots).key() == chain[step] :
+				children[child].isSolution(dest_cell, dest_robot);
+			if (on_chain) {
+				next = child;
+			}
+		}
+		ASSERT(next != -1, "cannot replay the solution found in " << work_dir);
+		moves->push_back(child_moves[next]);
+		robot_positions = children[next];
+	}
+}
+
+
+static double secondsSince(chrono::steady_clock::time_point start) {
+	return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+int solveRicochetBoardExternal(const Board& board, const RobotArrangement& robot_positions, const Position& dest,
+	const string& dest_color, vector<Move>* moves, const string& work_dir, size_t buffer_bytes, int max_depth,
+	SolverStats* stats) {
+
+	ASSERT(moves != NULL, "cannot write moves into a null vector");
+	ASSERT(board.isCompiled(), "the external search needs a compiled board");
+	size_t buffer_keys = buffer_bytes / sizeof(uint64_t);
+	ASSERT(buffer_keys >= size_t(NUM_MOVES), "the external search needs room for the children of one state");
+	chrono::steady_clock::time_point solve_start = chrono::steady_clock::now();
+	if (stats != NULL) {
+		stats->start("external_bfs");
+	}
+	moves->clear();
+
+	CompactArrangement start = board.normalized(CompactArrangement(robot_positions));
+	int dest_cell = cellOf(dest.getRow(), dest.getCol());
+	int dest_robot = getRobotIndex(dest_color);
+	int solution_length = -1;
+	if (start.isSolution(dest_cell, dest_robot)) {
+		solution_length = 0;
+		max_depth = 0;
+	}
+
+	ExternalProgress progress = {PROGRESS_MAGIC, PROGRESS_VERSION, 0, board.getFingerprint(),
+		start.canonical(board.getInterchangeableRobots(dest_robot)).key(), (uint32_t) dest_cell,
+		(uint32_t) dest_robot};
+	mkdir(work_dir.c_str(), 0755);
+	progress.num_layers = max_depth > 0 ? readProgress(work_dir, progress) : 0;
+	if (progress.num_layers == 0 && max_depth > 0) {
+		KeyWriter layer(layerPath(work_dir, 0));
+		layer.push(progress.start);
+		layer.finish();
+		progress.num_layers = 1;
+		writeProgress(work_dir, progress);
+	}
+
+	// a resumed search starts from its last finished layer, unless that one came out empty
+	int depth = int(progress.num_layers) - 1;
+	for (; depth >= 0 && depth + 1 < max_depth && numKeys(layerPath(work_dir, depth)) > 0; depth++) {
+		chrono::steady_clock::time_point layer_start = chrono::steady_clock::now();
+		DepthStats* layer_stats = stats != NULL ? stats->startDepth(depth) : NULL;
+
+		// runs left behind by an interrupted merge
+		for (int run = 0; unlink(runPath(work_dir, depth + 1, run).c_str()) == 0; run++) {}
+
+		bool solved;
+		uint64_t solution;
+		int num_runs = expandLayer(board, work_dir, depth, dest_cell, dest_robot, buffer_keys, &solved, &solution,
+			layer_stats);
+		if (solved) {
+			for (int run = 0; run < num_runs; run++) {
+				unlink(runPath(work_dir, depth + 1, run).c_str());
+			}
+			rebuildMoves(board, work_dir, start, depth, solution, dest_cell, dest_robot, moves);
+			solution_length = depth + 1;
+		} else {
+			long num_keys = mergeRuns(work_dir, depth, num_runs);
+			if (layer_stats != NULL) {
+				layer_stats->duplicate_hits = layer_stats->nodes_generated - num_keys;
+			}
+			progress.num_layers = depth + 2;
+			writeProgress(work_dir, progress);
+		}
+
+		if (layer_stats != NULL) {
+			layer_stats->seconds = secondsSince(layer_start);
+		}
+		if (solved) {
+			break;
+		}
+	}
+
+	if (stats != NULL) {
+		stats->solution_length = solution_length;
+		for (int layer = 0; layer < int(progress.num_layers); layer++) {
+			stats->visited_states += numKeys(layerPath(work_dir, layer));
+		}
+		stats->visited_bytes = buffer_keys * sizeof(uint64_t);
+		stats->seconds = secondsSince(solve_start);
+	}
+	return solution_length;
+}
@@ -0,0 +1,30 @@
+#ifndef EXTERNAL_H
+#define EXTERNAL_H
+
+#include "robots.h"
+#include "board.h"
+#include "solver.h"
+#include "stats.h"
+
+using namespace std;
+
+// bytes of children an external search collects before sorting them out to a run file, 256 MB
+extern size_t DEFAULT_EXTERNAL_BUFFER_BYTES;
+
+// breadth first search that keeps its layers on disk in work_dir, for puzzles whose states do not fit in memory.
+// each layer is a file of sorted canonical state keys. the children of a layer are collected in a buffer of
+// buffer_bytes, sorted and written out as a run whenever it fills. the runs are then merged into the next layer,
+// dropping every key that any earlier layer already holds, all by streaming. moves cannot be undone, so a state
+// can come back at any later depth, not just within the two layers that suffice for undirected searches.
+// each merge therefore rereads every earlier layer, so the disk traffic of layer d is the d layers before it
+// on top of its own runs: quadratic in the depth, though the deep layers dominate both sizes and the time.
+// in exchange every state is expanded once and an unsolvable puzzle stops at its first empty layer.
+// a finished layer is renamed into place and recorded in a progress file, so rerunning the same puzzle
+// on the same work_dir picks up after its last finished layer. every layer stays on disk, the path is rebuilt
+// from them once dest is reached. memory is the buffer plus a small read buffer per open file, one per layer.
+// finds solutions shorter than max_depth, returns the length or -1
+int solveRicochetBoardExternal(const Board& board, const RobotArrangement& robot_positions, const Position& dest,
+	const string& dest_color, vector<Move>* moves, const string& work_dir,
+	size_t buffer_bytes=DEFAULT_EXTERNAL_BUFFER_BYTES, int max_depth=DEFAULT_MAX_DEPTH, SolverStats* stats=NULL);
+
+#endif
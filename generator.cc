@@ -0,0 +1,181 @@
+#include "generator.h"
+#include "quadrant.h"
+#include "solver.h"
+
+#include <iostream>
+#include <memory>
+#include <atomic>
+#include <thread>
+
+using namespace std;
+
+// puzzles drawn per worker thread before their lengths are looked at
+static const int GENERATE_ROUND_SIZE = 16;
+
+
+static int randomBelow(mt19937* rng, int n) {
+	return (*rng)() % n;
+}
+
+static bool isCenterCell(int cell) {
+	int center = COMPILED_DIMENSION / 2;
+	return (rowOf(cell) == center - 1 || rowOf(cell) == center) && (colOf(cell) == center - 1 || colOf(cell) == center);
+}
+
+// boards by layout, generation keeps drawing the same few. only called from the drawing thread
+static const Board& getBoard(const array<int, 4>& layout) {
+	static map<array<int, 4>, unique_ptr<Board>> boards;
+	unique_ptr<Board>& board = boards[layout];
+	if (!board) {
+		board.reset(new Board());
+		buildBoard(board.get(), layout[0], layout[1], layout[2], layout[3]);
+	}
+	return *board;
+}
+
+static vector<int> quadrantsWithBarriers() {
+	vector<int> quadrant_nums;
+	for (int quadrant_num = 1; quadrant_num <= NUM_QUADRANTS; quadrant_num++) {
+		if (getQuadrantTable(quadrant_num).num_row_barriers > 0) {
+			quadrant_nums.push_back(quadrant_num);
+		}
+	}
+	return quadrant_nums;
+}
+
+
+void generatePuzzle(mt19937* rng, BatchPuzzle* puzzle) {
+	ASSERT(rng != NULL && puzzle != NULL, "cannot generate without an rng and a puzzle");
+	static const vector<int> QUADRANT_NUMS = quadrantsWithBarriers();
+	ASSERT(QUADRANT_NUMS.size() >= 4, "need four quadrants with barriers");
+
+	// partial fisher yates for four distinct quadrants
+	vector<int> quadrant_nums = QUADRANT_NUMS;
+	for (int position = 0; position < 4; position++) {
+		swap(quadrant_nums[position], quadrant_nums[position + randomBelow(rng, quadrant_nums.size() - position)]);
+		puzzle->layout[position] = quadrant_nums[position];
+	}
+	const Board& board = getBoard(puzzle->layout);
+
+	Bitboard diag_cells = board.getDiagCells();
+	Bitboard taken;
+	for (int cell = 0; cell < NUM_CELLS; cell++) {
+		if (isCenterCell(cell)) {
+			taken.set(cell);
+		}
+	}
+
+	// a robot on a diag cell got there from one of its sides, drawn at random from the sides a slide can enter
+	// by, and takes the above diag bit that slide gives it. a diag cell no slide enters is drawn again
+	puzzle->robot_positions = CompactArrangement();
+	for (int robot = 0; robot < NUM_ROBOTS; robot++) {
+		int cell;
+		bool above_diag = true;
+		bool placed = false;
+		while (!placed) {
+			cell = randomBelow(rng, NUM_CELLS);
+			if (taken.test(cell)) {
+				continue;
+			}
+			placed = !diag_cells.test(cell);
+			int directions[NUM_DIRECTIONS] = {NORTH, SOUTH, EAST, WEST};
+			for (int position = 0; position < NUM_DIRECTIONS && !placed; position++) {
+				swap(directions[position], directions[position + randomBelow(rng, NUM_DIRECTIONS - position)]);
+				placed = board.arrivalSide(cell, directions[position], robot, &above_diag);
+			}
+		}
+		taken.set(cell);
+		puzzle->robot_positions.setRobot(robot, cell, above_diag);
+	}
+
+	puzzle->dest_robot = randomBelow(rng, NUM_ROBOTS);
+	do {
+		puzzle->dest_cell = randomBelow(rng, NUM_CELLS);
+	} while (isCenterCell(puzzle->dest_cell) || diag_cells.test(puzzle->dest_cell) ||
+		puzzle->dest_cell == puzzle->robot_positions.getCell(puzzle->dest_robot));
+
+	puzzle->line_num = 0;
+	puzzle->error.clear();
+}
+
+
+long generateCorpus(ostream& out, unsigned seed, int puzzles_per_length, int min_length, int max_length,
+	long max_attempts, int num_threads) {
+
+	ASSERT(0 < min_length && min_length <= max_length, "bad length range " << min_length << " .. " << max_length);
+	if (num_threads <= 0) {
+		num_threads = max(1u, thread::hardware_concurrency());
+	}
+
+	mt19937 rng(seed);
+	vector<vector<string>> strata(max_length + 1);
+	int num_full = 0;
+	int num_strata = max_length - min_length + 1;
+
+	// puzzles are drawn and accepted in order on this thread, only the solving is spread over the workers,
+	// so the corpus does not depend on num_threads
+	long attempts = 0;
+	while (attempts < max_attempts && num_full < num_strata) {
+		int round_size = min((long) GENERATE_ROUND_SIZE * num_threads, max_attempts - attempts);
+		vector<BatchPuzzle> puzzles(round_size);
+		vector<const Board*> boards(round_size);
+		for (int i = 0; i < round_size; i++) {
+			generatePuzzle(&rng, &puzzles[i]);
+			boards[i] = &getBoard(puzzles[i].layout);
+		}
+
+		// anything longer than max_length is of no use, so the search stops there
+		vector<int> solution_lengths(round_size);
+		atomic<int> next_puzzle(0);
+		auto solve = [&] {
+			for (int i = next_puzzle++; i < round_size; i = next_puzzle++) {
+				const BatchPuzzle& puzzle = puzzles[i];
+				vector<Move> moves;
+				solution_lengths[i] = solveRicochetBoard(*boards[i],
+					puzzle.robot_positions.toRobotArrangement(), Position(rowOf(puzzle.dest_cell), colOf(puzzle.dest_cell)),
+					all_colors[puzzle.dest_robot], &moves, max_length + 1);
+			}
+		};
+		vector<thread> workers;
+		for (int i = 1; i < num_threads; i++) {
+			workers.push_back(thread(solve));
+		}
+		solve();
+		for (thread& worker : workers) {
+			worker.join();
+		}
+
+		for (int i = 0; i < round_size && num_full < num_strata; i++) {
+			attempts++;
+			int solution_length = solution_lengths[i];
+			if (solution_length < min_length || (int) strata[solution_length].size() >= puzzles_per_length) {
+				continue;
+			}
+
+			strata[solution_length].push_back(formatBatchPuzzle(puzzles[i]));
+			if ((int) strata[solution_length].size() == puzzles_per_length) {
+				num_full++;
+			}
+		}
+	}
+
+	out << "# seed " << seed << ", " << puzzles_per_length << " puzzles per optimal length from " << min_length
+		<< " to " << max_length << "\n";
+	long num_written = 0;
+	for (int length = min_length; length <= max_length; length++) {
+		out << "# length " << length << "\n";
+		for (const string& line : strata[length]) {
+			out << line << "\n";
+			num_written++;
+		}
+	}
+
+	out << "# " << num_written << " puzzles from " << attempts << " drawn";
+	for (int length = min_length; length <= max_length; length++) {
+		if ((int) strata[length].size() < puzzles_per_length) {
+			out << ", length " << length << " has " << strata[length].size();
+		}
+	}
+	out << "\n";
+	return num_written;
+}
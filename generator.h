@@ -0,0 +1,30 @@
+#ifndef GENERATOR_H
+#define GENERATOR_H
+
+#include "robots.h"
+#include "board.h"
+#include "batch.h"
+
+#include <ostream>
+#include <random>
+
+using namespace std;
+
+// random puzzles are drawn from a seeded mt19937 using only its raw output, so a seed gives
+// the same puzzles on every platform
+
+// four different quadrants that have barriers, each in a random position (which sets its orientation).
+// the robots go on distinct cells outside the center block. one on a diag cell is on the side of the
+// diag that a slide into the cell from a random neighbor leaves it (see Board::arrivalSide).
+// the target is any cell outside the center block and off the diags, not under the target robot
+void generatePuzzle(mt19937* rng, BatchPuzzle* puzzle);
+
+// writes a corpus in the batch format with puzzles_per_length puzzles of each optimal length from
+// min_length to max_length, grouped by length under "# length" comments. lengths that are still short
+// after max_attempts puzzles have been drawn are left short, and the summary comment at the end says so.
+// puzzles are solved on num_threads threads (0 picks one per hardware thread) to find their lengths.
+// the same seed and lengths always give the same corpus, whatever the thread count. returns the number of puzzles written
+long generateCorpus(ostream& out, unsigned seed, int puzzles_per_length, int min_length, int max_length,
+	long max_attempts, int num_threads=0);
+
+#endif
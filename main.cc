@@ -0,0 +1,348 @@
+#include "board.h"
+#include "solver.h"
+#include "quadrant.h"
+#include "batch.h"
+#include "generator.h"
+#include "external.h"
+#include "daemon.h"
+#include "optimal.h"
+#include "parallel.h"
+#include <iostream>
+#include <fstream>
+#include <memory>
+#include <chrono>
+#include <iomanip>
+
+using namespace std;
+
+// ricochet --batch [puzzle file, default stdin] [num threads] [solution cache file]
+static int runBatch(int argc, char* argv[], SearchAlgorithm algorithm) {
+	int num_threads = argc > 3 ? atoi(argv[3]) : 0;
+	unique_ptr<SolutionCache> cache;
+	if (argc > 4) {
+		cache.reset(new SolutionCache(argv[4]));
+		ASSERT(cache->isOpen(), "cannot open solution cache " << argv[4]);
+	}
+
+	int num_errors;
+	if (argc > 2 && string(argv[2]) != "-") {
+		ifstream puzzles(argv[2]);
+		ASSERT(puzzles, "cannot open " << argv[2]);
+		num_errors = solveBatch(puzzles, cout, num_threads, algorithm, DEFAULT_MAX_DEPTH, cache.get());
+	} else {
+		num_errors = solveBatch(cin, cout, num_threads, algorithm, DEFAULT_MAX_DEPTH, cache.get());
+	}
+
+	if (cache) {
+		cerr << "solution cache: " << cache->getHits() << " hits, " << cache->getMisses() << " misses, "
+			<< cache->size() << " puzzles stored" << endl;
+	}
+	return num_errors == 0 ? 0 : 1;
+}
+
+// ricochet --generate seed puzzles_per_length [min_length max_length [max_attempts]]
+// writes a corpus for --batch to stdout
+static int runGenerate(int argc, char* argv[]) {
+	ASSERT(argc > 3, "usage: ricochet --generate seed puzzles_per_length [min_length max_length [max_attempts]]");
+	unsigned seed = strtoul(argv[2], NULL, 10);
+	int puzzles_per_length = atoi(argv[3]);
+	int min_length = argc > 5 ? atoi(argv[4]) : 1;
+	int max_length = argc > 5 ? atoi(argv[5]) : 12;
+	long max_attempts = argc > 6 ? atol(argv[6]) : 200L * puzzles_per_length * (max_length - min_length + 1);
+	generateCorpus(cout, seed, puzzles_per_length, min_length, max_length, max_attempts);
+	return 0;
+}
+
+// a byte count with an optional K, M or G suffix, such as 512M
+static size_t parseByteCount(const string& text) {
+	char* end;
+	size_t count = strtoull(text.c_str(), &end, 10);
+	string suffix(end);
+	size_t unit = suffix == "" ? 1 : suffix == "K" ? size_t(1) << 10 : suffix == "M" ? size_t(1) << 20 :
+		suffix == "G" ? size_t(1) << 30 : 0;
+	ASSERT(end != text.c_str() && unit != 0, "cannot read a byte count from " << text);
+	return count * unit;
+}
+
+// search algorithm by the name the benchmarks and stats use
+static SearchAlgorithm parseSearchAlgorithm(const string& name) {
+	const pair<string, SearchAlgorithm> algorithms[] = {
+		{"iterative_deepening", ITERATIVE_DEEPENING},
+		{"breadth_first", BREADTH_FIRST},
+		{"ida_star", IDA_STAR},
+		{"parallel_breadth_first", PARALLEL_BREADTH_FIRST},
+	};
+	for (const pair<string, SearchAlgorithm>& algorithm : algorithms) {
+		if (algorithm.first == name) {
+			return algorithm.second;
+		}
+	}
+	ASSERT(false, "unknown algorithm " << name
+		<< ", expected iterative_deepening, breadth_first, ida_star or parallel_breadth_first");
+	return ITERATIVE_DEEPENING;
+}
+
+// ricochet --daemon socket_path [solution cache file [worker threads]] serves solves on a unix socket until killed.
+// pass - for no cache
+static int runDaemon(int argc, char* argv[]) {
+	ASSERT(argc > 2, "usage: ricochet --daemon socket_path [solution cache file [worker threads]]");
+	if (argc > 4) {
+		DAEMON_WORKER_THREADS = atoi(argv[4]);
+	}
+	unique_ptr<SolutionCache> cache;
+	if (argc > 3 && string(argv[3]) != "-") {
+		cache.reset(new SolutionCache(argv[3]));
+		ASSERT(cache->isOpen(), "cannot open solution cache " << argv[3]);
+	}
+	runSolverDaemon(argv[2], cache.get());
+	return 0;
+}
+
+// ricochet --all-targets [max depth] < puzzles, in the --batch format, whose targets are ignored. writes per puzzle
+//   line_num num_solved millis
+// for the targets reached in fewer than max depth moves (default DEFAULT_ALL_TARGETS_DEPTH), followed by one line
+// per robot and cell reached, robots in color order and cells in row order, as
+//   line_num color row col length color,direction color,direction ...
+static int runAllTargets(int argc, char* argv[]) {
+	int max_depth = argc > 2 ? atoi(argv[2]) : DEFAULT_ALL_TARGETS_DEPTH;
+
+	BoardCache boards;
+	string line;
+	int line_num = 0;
+	int num_errors = 0;
+	while (getline(cin, line)) {
+		line_num++;
+		size_t first = line.find_first_not_of(" \t\r");
+		if (first == string::npos || line[first] == '#') {
+			continue;
+		}
+		BatchPuzzle puzzle;
+		if (!parseBatchPuzzle(line, line_num, &puzzle)) {
+			cout << line_num << " error " << puzzle.error << endl;
+			num_errors++;
+			continue;
+		}
+
+		shared_ptr<const Board> board_ref = boards.getBoard(puzzle.layout);
+		const Board& board = *board_ref;
+		AllTargetsSolution solution;
+		auto start = chrono::steady_clock::now();
+		solveAllTargets(board, puzzle.robot_positions.toRobotArrangement(), &solution, max_depth);
+		double millis = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+		cout << line_num << " " << solution.numSolved() << " " << fixed << setprecision(3) << millis << "\n";
+
+		for (int robot = 0; robot < NUM_ROBOTS; robot++) {
+			for (int cell = 0; cell < NUM_CELLS; cell++) {
+				vector<Move> moves;
+				int solution_length = solution.getSolution(Position(rowOf(cell), colOf(cell)), all_colors[robot], &moves);
+				if (solution_length == -1) {
+					continue;
+				}
+				cout << line_num << " " << all_colors[robot] << " " << rowOf(cell) << " " << colOf(cell) << " "
+					<< solution_length;
+				for (Move move : moves) {
+					cout << " " << getColor(move) << "," << getDirection(move);
+				}
+				cout << "\n";
+			}
+		}
+	}
+	cout.flush();
+	return num_errors == 0 ? 0 : 1;
+}
+
+// ricochet --client socket_path [max depth] sends the puzzles on stdin, in the --batch format, to a daemon
+// and writes the results as --batch does, with the round trip in place of the solve time
+static int runClient(int argc, char* argv[], SearchAlgorithm algorithm) {
+	ASSERT(argc > 2, "usage: ricochet --client socket_path [max depth] < puzzles");
+	int max_depth = argc > 3 ? atoi(argv[3]) : min(DEFAULT_MAX_DEPTH, MAX_DAEMON_MOVES + 1);
+	int num_errors = runDaemonClient(cin, cout, argv[2], algorithm, max_depth);
+	return num_errors == 0 ? 0 : 1;
+}
+
+// ricochet --external work_dir [buffer bytes [max depth]] solves the first puzzle on stdin, in the --batch format,
+// with the search kept on disk in work_dir. writes one result line as --batch does.
+// rerun on the same work_dir, an interrupted search carries on from its last finished layer
+static int runExternal(int argc, char* argv[]) {
+	ASSERT(argc > 2, "usage: ricochet --external work_dir [buffer bytes [max depth]] < puzzle");
+	size_t buffer_bytes = argc > 3 ? parseByteCount(argv[3]) : DEFAULT_EXTERNAL_BUFFER_BYTES;
+	int max_depth = argc > 4 ? atoi(argv[4]) : DEFAULT_MAX_DEPTH;
+
+	string line;
+	int line_num = 0;
+	BatchPuzzle puzzle;
+	bool found = false;
+	while (!found && getline(cin, line)) {
+		line_num++;
+		size_t first = line.find_first_not_of(" \t\r");
+		found = first != string::npos && line[first] != '#';
+	}
+	ASSERT(found, "no puzzle on stdin");
+	bool parsed = parseBatchPuzzle(line, line_num, &puzzle);
+	ASSERT(parsed, "line " << line_num << ": " << puzzle.error);
+
+	Board board;
+	buildBoard(&board, puzzle.layout[0], puzzle.layout[1], puzzle.layout[2], puzzle.layout[3]);
+	Position dest(rowOf(puzzle.dest_cell), colOf(puzzle.dest_cell));
+	vector<Move> moves;
+	auto start = chrono::steady_clock::now();
+	int solution_length = solveRicochetBoardExternal(board, puzzle.robot_positions.toRobotArrangement(), dest,
+		all_colors[puzzle.dest_robot], &moves, argv[2], buffer_bytes, max_depth);
+	double millis = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+
+	cout << line_num << " " << solution_length << " " << fixed << setprecision(3) << millis;
+	for (Move move : moves) {
+		cout << " " << getColor(move) << "," << getDirection(move);
+	}
+	cout << endl;
+	return 0;
+}
+
+// ricochet --optimal [solutions to list] [max depth] < puzzles, in the --batch format. writes per puzzle
+//   line_num length num_optimal_solutions millis
+// followed by up to the given number of them (default none), one per line as
+//   line_num color,direction color,direction ...
+static int runOptimal(int argc, char* argv[]) {
+	long num_listed = argc > 2 ? atol(argv[2]) : 0;
+	int max_depth = argc > 3 ? atoi(argv[3]) : DEFAULT_MAX_DEPTH;
+
+	BoardCache boards;
+	string line;
+	int line_num = 0;
+	int num_errors = 0;
+	while (getline(cin, line)) {
+		line_num++;
+		size_t first = line.find_first_not_of(" \t\r");
+		if (first == string::npos || line[first] == '#') {
+			continue;
+		}
+		BatchPuzzle puzzle;
+		if (!parseBatchPuzzle(line, line_num, &puzzle)) {
+			cout << line_num << " error " << puzzle.error << endl;
+			num_errors++;
+			continue;
+		}
+
+		shared_ptr<const Board> board_ref = boards.getBoard(puzzle.layout);
+		const Board& board = *board_ref;
+		Position dest(rowOf(puzzle.dest_cell), colOf(puzzle.dest_cell));
+		OptimalSolutionDag dag;
+		auto start = chrono::steady_clock::now();
+		int solution_length = solveAllOptimal(board, puzzle.robot_positions.toRobotArrangement(), dest,
+			all_colors[puzzle.dest_robot], &dag, max_depth);
+		double millis = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+		cout << line_num << " " << solution_length << " " << dag.countSolutions() << " " << fixed << setprecision(3)
+			<< millis << "\n";
+
+		long num_left = num_listed;
+		dag.forEachSolution([&](const vector<Move>& moves) {
+			if (num_left <= 0) {
+				return false;
+			}
+			num_left--;
+			cout << line_num;
+			for (Move move : moves) {
+				cout << " " << getColor(move) << "," << getDirection(move);
+			}
+			cout << "\n";
+			return true;
+		});
+	}
+	cout.flush();
+	return num_errors == 0 ? 0 : 1;
+}
+
+// ricochet [--mem-limit bytes] [--algorithm name] [--search-threads n] [--stats json|prometheus] solves the demo
+// puzzle, and with --stats dumps what the search did to stderr. these options come before any other:
+//   --mem-limit caps the table of each solve
+//   --algorithm picks the search of the demo, --batch and --client: iterative_deepening (the default),
+//     breadth_first, ida_star or parallel_breadth_first
+//   --search-threads sets the threads of parallel_breadth_first, by default one per hardware thread.
+//     --batch runs several solves at once, so pair the two with a batch of one thread
+int main(int argc, char* argv[]) {
+
+	SearchAlgorithm algorithm = ITERATIVE_DEEPENING;
+	while (argc > 2) {
+		string option = argv[1];
+		if (option == "--mem-limit") {
+			SEARCH_MEMORY_LIMIT = parseByteCount(argv[2]);
+			ASSERT(SEARCH_MEMORY_LIMIT >= BOUNDED_BUCKET_ENTRIES * sizeof(uint64_t), "--mem-limit is too small");
+		} else if (option == "--algorithm") {
+			algorithm = parseSearchAlgorithm(argv[2]);
+		} else if (option == "--search-threads") {
+			PARALLEL_SEARCH_THREADS = atoi(argv[2]);
+		} else {
+			break;
+		}
+		argv[2] = argv[0];
+		argc -= 2;
+		argv += 2;
+	}
+
+	if (argc > 1 && string(argv[1]) == "--batch") {
+		return runBatch(argc, argv, algorithm);
+	}
+	if (argc > 1 && string(argv[1]) == "--generate") {
+		return runGenerate(argc, argv);
+	}
+	if (argc > 1 && string(argv[1]) == "--external") {
+		return runExternal(argc, argv);
+	}
+	if (argc > 1 && string(argv[1]) == "--optimal") {
+		return runOptimal(argc, argv);
+	}
+	if (argc > 1 && string(argv[1]) == "--all-targets") {
+		return runAllTargets(argc, argv);
+	}
+	if (argc > 1 && string(argv[1]) == "--daemon") {
+		return runDaemon(argc, argv);
+	}
+	if (argc > 1 && string(argv[1]) == "--client") {
+		return runClient(argc, argv, algorithm);
+	}
+
+	Board board;
+	buildBoard(&board, 1, 3, 5, 7);
+
+	Position yellow_robot(5, 7);
+	Position red_robot(13, 5);
+	Position green_robot(2, 6);
+	Position blue_robot(10, 9);
+
+	Position dest(14, 9);
+
+	RobotArrangement robot_positions({{"yellow", yellow_robot}, {"red", red_robot}, {"green", green_robot}, {"blue", blue_robot}});
+
+	board.display(robot_positions, dest);
+	string dest_color {"yellow"};
+
+	string stats_format = argc > 2 && string(argv[1]) == "--stats" ? argv[2] : "";
+	ASSERT(stats_format == "" || stats_format == "json" || stats_format == "prometheus",
+		"unknown stats format " << stats_format);
+
+	vector<vector<Move>> solutions;
+	SolverStats stats;
+	int solution_length = solveRicochetBoard(board, robot_positions, dest, dest_color, &solutions, 1, algorithm,
+		DEFAULT_MAX_DEPTH, &stats);
+	bool solved = solution_length != -1;
+	if (solved) {
+		log("Solution takes " + to_string(solution_length) + " moves");
+		printMoves(solutions[0]);
+	} else {
+		log("no solution found");
+	}
+	log("Searched " + to_string(stats.getNodesExpanded()) + " nodes to depth " + to_string(stats.depths.back().depth));
+
+	if (stats_format == "json") {
+		cerr << stats.toJson() << endl;
+	} else if (stats_format == "prometheus") {
+		cerr << stats.toPrometheus();
+	}
+	
+
+
+
+	//vector<Move> solution;
+	//bool is_solution = solveDepthLimitedDfs(board, robot_positions, dest, dest_color, &solution);
+
+}
\ No newline at end of file
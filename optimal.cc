@@ -0,0 +1,251 @@
+#include "optimal.h"
+#include "visited.h"
+
+#include <iostream>
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+
+using namespace std;
+
+// an edge holds its parent's index above the 4 bit move
+static const size_t MAX_LAYER_STATES = size_t(1) << 28;
+
+
+static double secondsSince(chrono::steady_clock::time_point start) {
+	return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+static uint64_t saturatingAdd(uint64_t a, uint64_t b) {
+	return a > UINT64_MAX - b ? UINT64_MAX : a + b;
+}
+
+
+OptimalSolutionDag::OptimalSolutionDag() : solution_length(-1), num_solutions(0) {}
+
+int OptimalSolutionDag::getSolutionLength() const {
+	return this->solution_length;
+}
+
+uint64_t OptimalSolutionDag::countSolutions() const {
+	return this->num_solutions;
+}
+
+size_t OptimalSolutionDag::numStates() const {
+	size_t total = 0;
+	for (const vector<uint64_t>& layer : this->states) {
+		total += layer.size();
+	}
+	return total;
+}
+
+size_t OptimalSolutionDag::numEdges() const {
+	size_t total = 0;
+	for (const vector<uint32_t>& layer : this->edges) {
+		total += layer.size();
+	}
+	return total;
+}
+
+size_t OptimalSolutionDag::bytes() const {
+	size_t total = this->numStates() * sizeof(uint64_t) + this->numEdges() * sizeof(uint32_t);
+	for (const vector<uint32_t>& layer : this->edge_offsets) {
+		total += layer.size() * sizeof(uint32_t);
+	}
+	return total;
+}
+
+void OptimalSolutionDag::forEachSolution(const function<bool(const vector<Move>&)>& visit) const {
+	int length = this->solution_length;
+	if (length <= 0) {
+		if (length == 0) {
+			visit(vector<Move>());
+		}
+		return;
+	}
+
+	// walks back from each solved state to the start, one edge per layer. picked[d] is the state chosen in
+	// layer d and next_edge[d] the next of its edges to try, so only one move list exists at a time
+	vector<uint32_t> picked(length + 1);
+	vector<uint32_t> next_edge(length + 1);
+	vector<Move> moves(length);
+	for (uint32_t solved = 0; solved < this->states[length].size(); solved++) {
+		picked[length] = solved;
+		next_edge[length] = this->edge_offsets[length][solved];
+		int depth = length;
+		while (depth <= length) {
+			if (depth == 0) {
+				if (!visit(moves)) {
+					return;
+				}
+				depth++;
+				continue;
+			}
+			if (next_edge[depth] == this->edge_offsets[depth][picked[depth] + 1]) {
+				depth++;
+				continue;
+			}
+
+			uint32_t edge = this->edges[depth][next_edge[depth]++];
+			moves[depth - 1] = edge & 0xf;
+			picked[depth - 1] = edge >> 4;
+			depth--;
+			if (depth > 0) {
+				next_edge[depth] = this->edge_offsets[depth][picked[depth]];
+			}
+		}
+	}
+}
+
+
+int solveAllOptimal(const Board& board, const RobotArrangement& robot_positions, const Position& dest,
+	const string& dest_color, OptimalSolutionDag* dag, int max_depth, SolverStats* stats) {
+
+	ASSERT(dag != NULL, "cannot fill a null dag");
+	chrono::steady_clock::time_point solve_start = chrono::steady_clock::now();
+	if (stats != NULL) {
+		stats->start("all_optimal");
+	}
+	*dag = OptimalSolutionDag();
+
+	CompactArrangement start = board.normalized(CompactArrangement(robot_positions));
+	int dest_cell = cellOf(dest.getRow(), dest.getCol());
+	int dest_robot = getRobotIndex(dest_color);
+
+	// forward: layers[d] holds every arrangement first reached in d moves, solved holds the arrangements on dest
+	// in the first layer that has any
+	vector<vector<uint64_t>> layers(1, vector<uint64_t>(1, start.key()));
+	vector<uint64_t> solved;
+	// the visited table dedups off the diags by key() >> 4 while the layers and the backward pass use the whole key.
+	// they agree because the start is normalized and moves clear the above diag bit off the diags
+	VisitedTable visited(board);
+	visited.insert(start);
+	int solution_length = start.isSolution(dest_cell, dest_robot) ? 0 : -1;
+	for (int depth = 0; solution_length == -1 && depth + 1 < max_depth && !layers[depth].empty(); depth++) {
+		chrono::steady_clock::time_point layer_start = chrono::steady_clock::now();
+		DepthStats* layer_stats = stats != NULL ? stats->startDepth(depth) : NULL;
+
+		vector<uint64_t> next_layer;
+		for (uint64_t key : layers[depth]) {
+			CompactArrangement children[NUM_MOVES];
+			Move child_moves[NUM_MOVES];
+			int num_children = board.generateChildren(CompactArrangement::fromKey(key), children, child_moves);
+			visited.prefetch(children, num_children);
+			if (layer_stats != NULL) {
+				layer_stats->nodes_expanded++;
+				layer_stats->nodes_generated += num_children;
+			}
+
+			for (int child = 0; child < num_children; child++) {
+				// an arrangement on dest cannot have been seen before, that would be a shorter solution
+				if (children[child].isSolution(dest_cell, dest_robot)) {
+					solved.push_back(children[child].key());
+				} else if (visited.insert(children[child])) {
+					next_layer.push_back(children[child].key());
+				} else if (layer_stats != NULL) {
+					layer_stats->duplicate_hits++;
+				}
+			}
+		}
+
+		if (!solved.empty()) {
+			solution_length = depth + 1;
+		} else {
+			ASSERT(next_layer.size() < MAX_LAYER_STATES, "layer " << depth + 1 << " is too large for the dag");
+			layers.push_back(move(next_layer));
+		}
+		if (layer_stats != NULL) {
+			layer_stats->seconds = secondsSince(layer_start);
+		}
+	}
+
+	if (stats != NULL) {
+		stats->visited_states = visited.size();
+		stats->visited_bytes = visited.bytes();
+	}
+	dag->solution_length = solution_length;
+	if (solution_length == -1) {
+		if (stats != NULL) {
+			stats->seconds = secondsSince(solve_start);
+		}
+		return -1;
+	}
+
+	// backward: keep the arrangements of each layer with a child kept in the next, and the edges to those children
+	dag->states.resize(solution_length + 1);
+	dag->edge_offsets.resize(solution_length + 1);
+	dag->edges.resize(solution_length + 1);
+	if (solution_length == 0) {
+		dag->states[0].push_back(start.key());
+	} else {
+		sort(solved.begin(), solved.end());
+		solved.erase(unique(solved.begin(), solved.end()), solved.end());
+		dag->states[solution_length] = move(solved);
+	}
+
+	for (int depth = solution_length - 1; depth >= 0; depth--) {
+		const vector<uint64_t>& kept_children = dag->states[depth + 1];
+		vector<uint64_t>& layer = layers[depth];
+		sort(layer.begin(), layer.end());
+
+		vector<pair<uint32_t, uint32_t>> child_edges; // child index, edge
+		for (uint64_t key : layer) {
+			CompactArrangement children[NUM_MOVES];
+			Move child_moves[NUM_MOVES];
+			int num_children = board.generateChildren(CompactArrangement::fromKey(key), children, child_moves);
+			uint32_t parent = dag->states[depth].size();
+			bool kept = false;
+			for (int child = 0; child < num_children; child++) {
+				uint64_t child_key = children[child].key();
+				auto found = lower_bound(kept_children.begin(), kept_children.end(), child_key);
+				if (found != kept_children.end() && *found == child_key) {
+					child_edges.push_back(make_pair(uint32_t(found - kept_children.begin()),
+						(parent << 4) | uint32_t(child_moves[child])));
+					kept = true;
+				}
+			}
+			if (kept) {
+				dag->states[depth].push_back(key);
+			}
+		}
+		vector<uint64_t>().swap(layer);
+
+		// counting sort of the edges by child
+		vector<uint32_t>& offsets = dag->edge_offsets[depth + 1];
+		offsets.assign(kept_children.size() + 1, 0);
+		for (const pair<uint32_t, uint32_t>& child_edge : child_edges) {
+			offsets[child_edge.first + 1]++;
+		}
+		for (size_t i = 1; i < offsets.size(); i++) {
+			offsets[i] += offsets[i - 1];
+		}
+		vector<uint32_t>& layer_edges = dag->edges[depth + 1];
+		layer_edges.resize(child_edges.size());
+		vector<uint32_t> next_slot(offsets.begin(), offsets.end() - 1);
+		for (const pair<uint32_t, uint32_t>& child_edge : child_edges) {
+			layer_edges[next_slot[child_edge.first]++] = child_edge.second;
+		}
+	}
+
+	// paths from the start to each kept arrangement, one layer at a time
+	vector<uint64_t> num_paths(1, 1);
+	for (int depth = 1; depth <= solution_length; depth++) {
+		vector<uint64_t> next_num_paths(dag->states[depth].size(), 0);
+		for (size_t i = 0; i < next_num_paths.size(); i++) {
+			for (uint32_t edge = dag->edge_offsets[depth][i]; edge < dag->edge_offsets[depth][i + 1]; edge++) {
+				next_num_paths[i] = saturatingAdd(next_num_paths[i], num_paths[dag->edges[depth][edge] >> 4]);
+			}
+		}
+		num_paths.swap(next_num_paths);
+	}
+	dag->num_solutions = 0;
+	for (uint64_t paths : num_paths) {
+		dag->num_solutions = saturatingAdd(dag->num_solutions, paths);
+	}
+
+	if (stats != NULL) {
+		stats->solution_length = solution_length;
+		stats->seconds = secondsSince(solve_start);
+	}
+	return solution_length;
+}
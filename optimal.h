@@ -0,0 +1,53 @@
+#ifndef OPTIMAL_H
+#define OPTIMAL_H
+
+#include "robots.h"
+#include "board.h"
+#include "solver.h"
+#include "stats.h"
+
+#include <functional>
+
+using namespace std;
+
+// every optimal solution of one puzzle, kept as a layered dag rather than as paths. layer d holds the states
+// d moves from the start that lie on at least one optimal solution, and each of them keeps its edges back to
+// the states of layer d - 1 that lead to it, one 32 bit word per edge: the parent's index in its layer
+// and the 4 bit move. memory grows with the states and edges, never with the number of solutions
+class OptimalSolutionDag {
+
+	int solution_length; // -1 if there is no solution shorter than the max depth searched
+	vector<vector<uint64_t>> states; // per layer, sorted CompactArrangement keys
+	vector<vector<uint32_t>> edge_offsets; // per layer, edges of state i are edges[offsets[i], offsets[i + 1])
+	vector<vector<uint32_t>> edges; // per layer, parent index << 4 | move
+	uint64_t num_solutions;
+
+	friend int solveAllOptimal(const Board& board, const RobotArrangement& robot_positions, const Position& dest,
+		const string& dest_color, OptimalSolutionDag* dag, int max_depth, SolverStats* stats);
+
+public:
+
+	OptimalSolutionDag();
+
+	int getSolutionLength() const;
+
+	// number of distinct optimal move lists, counted over the dag without listing them.
+	// saturates at UINT64_MAX
+	uint64_t countSolutions() const;
+
+	size_t numStates() const;
+	size_t numEdges() const;
+	size_t bytes() const;
+
+	// calls visit with each optimal move list in turn, building one at a time, until it returns false
+	void forEachSolution(const function<bool(const vector<Move>&)>& visit) const;
+};
+
+// fills dag with every optimal solution shorter than max_depth. a breadth first search over the full
+// arrangements (no helper symmetry, which would merge solutions) runs until a layer reaches dest, keeping
+// every layer. a backward pass from the solved states then keeps only the states with a child on some
+// optimal solution and links them up. returns the optimal length, or -1
+int solveAllOptimal(const Board& board, const RobotArrangement& robot_positions, const Position& dest,
+	const string& dest_color, OptimalSolutionDag* dag, int max_depth=DEFAULT_MAX_DEPTH, SolverStats* stats=NULL);
+
+#endif
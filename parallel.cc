@@ -0,0 +1,190 @@
+#include "parallel.h"
+
+#include <iostream>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <chrono>
+
+using namespace std;
+
+int MIN_PARALLEL_LAYER = 4096;
+int PARALLEL_SEARCH_THREADS = 0;
+
+// layer entries claimed by a worker at a time
+static const int CHUNK_SIZE = 256;
+
+
+// one state of a layer, with the index of its parent in the previous layer
+struct LayerNode {
+	CompactArrangement robot_positions;
+	int parent;
+	Move move;
+};
+
+// everything the workers of one layer share
+struct LayerWork {
+	const Board* board;
+	const vector<LayerNode>* layer;
+	AtomicVisitedSet* visited;
+	int dest_cell;
+	int dest_robot;
+	int interchangeable_robots;
+
+	atomic<int> next_chunk;
+	atomic<bool> solved;
+	atomic<long> nodes_expanded;
+	atomic<long> nodes_generated;
+	atomic<long> duplicate_hits;
+	mutex solution_mutex;
+	int solution_parent; // smallest (parent, move) in this layer that reaches dest. the layer's order, and so the
+	// path, still depends on timing, only the length does not
+	Move solution_move;
+};
+
+// counts are kept per worker and added to the shared ones once the layer runs out
+static void expandLayer(LayerWork* work, vector<LayerNode>* children) {
+	const vector<LayerNode>& layer = *work->layer;
+	int layer_size = layer.size();
+	long nodes_expanded = 0;
+	long nodes_generated = 0;
+	long duplicate_hits = 0;
+
+	while (!work->solved.load(memory_order_relaxed)) {
+		int begin = work->next_chunk.fetch_add(CHUNK_SIZE);
+		if (begin >= layer_size) {
+			break;
+		}
+		int end = min(begin + CHUNK_SIZE, layer_size);
+
+		for (int node = begin; node < end; node++) {
+			CompactArrangement new_children[NUM_MOVES];
+			Move child_moves[NUM_MOVES];
+			int num_children = work->board->generateChildren(layer[node].robot_positions, new_children, child_moves);
+			nodes_expanded++;
+			nodes_generated += num_children;
+			for (int child = 0; child < num_children; child++) {
+				const CompactArrangement& new_robot_positions = new_children[child];
+				Move move = child_moves[child];
+
+				if (new_robot_positions.isSolution(work->dest_cell, work->dest_robot)) {
+					lock_guard<mutex> lock(work->solution_mutex);
+					if (!work->solved || make_pair(node, move) < make_pair(work->solution_parent, work->solution_move)) {
+						work->solution_parent = node;
+						work->solution_move = move;
+					}
+					work->solved = true;
+					continue;
+				}
+
+				if (work->visited->insert(new_robot_positions.canonical(work->interchangeable_robots))) {
+					children->push_back({new_robot_positions, node, move});
+				} else {
+					duplicate_hits++;
+				}
+			}
+		}
+	}
+
+	work->nodes_expanded += nodes_expanded;
+	work->nodes_generated += nodes_generated;
+	work->duplicate_hits += duplicate_hits;
+}
+
+
+static double secondsSince(chrono::steady_clock::time_point start) {
+	return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+
+int solveRicochetBoardParallel(const Board& board, const RobotArrangement& robot_positions, const Position& dest,
+	const string& dest_color, vector<Move>* moves, int num_threads, int max_depth, SolverStats* stats) {
+
+	ASSERT(moves != NULL, "cannot write moves into a null vector");
+	chrono::steady_clock::time_point solve_start = chrono::steady_clock::now();
+	if (stats != NULL) {
+		stats->start("parallel_breadth_first");
+	}
+	if (num_threads <= 0) {
+		num_threads = max(1u, thread::hardware_concurrency());
+	}
+
+	CompactArrangement start = board.normalized(CompactArrangement(robot_positions));
+	int dest_cell = cellOf(dest.getRow(), dest.getCol());
+	int dest_robot = getRobotIndex(dest_color);
+	int solution_length = start.isSolution(dest_cell, dest_robot) ? 0 : -1;
+
+	int interchangeable_robots = board.getInterchangeableRobots(dest_robot);
+	AtomicVisitedSet visited(board);
+	visited.insert(start.canonical(interchangeable_robots));
+	vector<vector<LayerNode>> layers(1, vector<LayerNode>(1, {start, -1, -1}));
+	long visited_states = 1;
+
+	for (int depth = 0; solution_length == -1 && depth + 1 < max_depth && !layers.back().empty(); depth++) {
+		chrono::steady_clock::time_point layer_start = chrono::steady_clock::now();
+		LayerWork work;
+		work.board = &board;
+		work.layer = &layers.back();
+		work.visited = &visited;
+		work.dest_cell = dest_cell;
+		work.dest_robot = dest_robot;
+		work.interchangeable_robots = interchangeable_robots;
+		work.next_chunk = 0;
+		work.solved = false;
+		work.nodes_expanded = 0;
+		work.nodes_generated = 0;
+		work.duplicate_hits = 0;
+
+		int num_workers = layers.back().size() < (size_t) MIN_PARALLEL_LAYER ? 1 : num_threads;
+		vector<vector<LayerNode>> buffers(num_workers);
+		vector<thread> workers;
+		for (int worker = 1; worker < num_workers; worker++) {
+			workers.push_back(thread(expandLayer, &work, &buffers[worker]));
+		}
+		expandLayer(&work, &buffers[0]);
+		for (thread& worker : workers) {
+			worker.join();
+		}
+		if (stats != NULL) {
+			DepthStats* layer_stats = stats->startDepth(depth);
+			layer_stats->nodes_expanded = work.nodes_expanded;
+			layer_stats->nodes_generated = work.nodes_generated;
+			layer_stats->duplicate_hits = work.duplicate_hits;
+			layer_stats->seconds = secondsSince(layer_start);
+		}
+
+		if (work.solved) {
+			// walk the parents back through the layers
+			moves->clear();
+			moves->push_back(work.solution_move);
+			int node = work.solution_parent;
+			for (int layer = depth; layer > 0; layer--) {
+				moves->push_back(layers[layer][node].move);
+				node = layers[layer][node].parent;
+			}
+			reverse(moves->begin(), moves->end());
+			solution_length = depth + 1;
+			break;
+		}
+
+		// merge the per thread buffers into the next frontier
+		size_t next_size = 0;
+		for (const vector<LayerNode>& buffer : buffers) {
+			next_size += buffer.size();
+		}
+		layers.push_back(vector<LayerNode>());
+		layers.back().reserve(next_size);
+		for (const vector<LayerNode>& buffer : buffers) {
+			layers.back().insert(layers.back().end(), buffer.begin(), buffer.end());
+		}
+		visited_states += next_size;
+	}
+
+	if (stats != NULL) {
+		stats->solution_length = solution_length;
+		stats->visited_states = visited_states;
+		stats->seconds = secondsSince(solve_start);
+	}
+	return solution_length;
+}
@@ -0,0 +1,24 @@
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include "robots.h"
+#include "board.h"
+#include "solver.h"
+
+using namespace std;
+
+// layers smaller than this are expanded on the calling thread, spawning workers costs more than it saves
+extern int MIN_PARALLEL_LAYER;
+
+// worker threads of the PARALLEL_BREADTH_FIRST algorithm, 0 for one per hardware thread
+extern int PARALLEL_SEARCH_THREADS;
+
+// level synchronous breadth first search, expanding each layer across num_threads worker threads
+// (0 picks one per hardware thread). workers claim chunks of the layer, drop duplicates through a shared
+// AtomicVisitedSet and collect children in their own buffers, which are appended to form the next layer.
+// finds the same optimal length as solveRicochetBoard, though which optimal path comes back can vary run to run
+int solveRicochetBoardParallel(const Board& board, const RobotArrangement& robot_positions, const Position& dest,
+	const string& dest_color, vector<Move>* moves, int num_threads=0, int max_depth=DEFAULT_MAX_DEPTH,
+	SolverStats* stats=NULL);
+
+#endif
@@ -1,246 +1,77 @@
 #include "quadrant.h"
+#include <iostream>
 
 using namespace std;
 
 int QUADRANT_DIMENSION = 8;
 
-Quadrant::Quadrant(int quadrant_num, int quadrant_dimension) {
-
-	for (int row = 0; row < quadrant_dimension; row++) {
-		// set edge of board barriers
-		vector<int> rb_indices;
-		this->row_barriers.push_back(rb_indices);
-		insertInOrder(&(this->row_barriers[row]), 0);
-
-		// initialize diag list
-		vector<pair<int, DiagBarrier>> db_indices;
-		this->diag_barriers.push_back(db_indices);
-	}
-
-	for (int col = 0; col < quadrant_dimension; col++) {
-		// set edge of board barriers
-		vector<int> cb_indices;
-		this->col_barriers.push_back(cb_indices);
-		insertInOrder(&(this->col_barriers[col]), 0);
-	}
-
-	switch (quadrant_num) {
-		case 1: createQuadrant1(this); break;
-		case 2: createQuadrant2(this); break;
-		case 3: createQuadrant3(this); break;
-		case 4: createQuadrant4(this); break;
-		case 5: createQuadrant5(this); break;
-		case 6: createQuadrant6(this); break;
-		case 7: createQuadrant7(this); break;
-		case 8: createQuadrant8(this); break;
-		default: break;
-	}
-}
-
-
-
-
-void createQuadrant1(Quadrant* quad) {
-
-	quad->setRowBarrier(0, 4);
-	quad->setRowBarrier(1, 1);
-	quad->setRowBarrier(2, 7);
-	quad->setRowBarrier(4, 3);
-	quad->setRowBarrier(5, 7);
-	quad->setRowBarrier(7, 7);
-
-	quad->setColBarrier(0, 6);
-	quad->setColBarrier(1, 2);
-	quad->setColBarrier(2, 5);
-	quad->setColBarrier(6, 2);
-	quad->setColBarrier(7, 5);
-	quad->setColBarrier(7, 7);
-
-}
-
-void createQuadrant2(Quadrant* quad) {
-
-	quad->setRowBarrier(0, 4);
-	quad->setRowBarrier(2, 6);
-	quad->setRowBarrier(4, 3);
-	quad->setRowBarrier(5, 7);
-	quad->setRowBarrier(6, 1);
-	quad->setRowBarrier(7, 7);
-
-	quad->setColBarrier(0, 5);
-	quad->setColBarrier(1, 6);
-	quad->setColBarrier(2, 4);
-	quad->setColBarrier(5, 3);
-	quad->setColBarrier(7, 6);
-	quad->setColBarrier(7, 7);
-
-}
-
-void createQuadrant3(Quadrant* quad) {
-
-	quad->setRowBarrier(0, 5);
-	quad->setRowBarrier(1, 2);
-	quad->setRowBarrier(3, 6);
-	quad->setRowBarrier(5, 5);
-	quad->setRowBarrier(6, 2);
-	quad->setRowBarrier(7, 7);
-
-	quad->setColBarrier(0, 5);
-	quad->setColBarrier(1, 7);
-	quad->setColBarrier(2, 1);
-	quad->setColBarrier(4, 5);
-	quad->setColBarrier(6, 4);
-	quad->setColBarrier(7, 7);
-
-}
-
-void createQuadrant4(Quadrant* quad) {
-
-	quad->setRowBarrier(0, 4);
-	quad->setRowBarrier(1, 6);
-	quad->setRowBarrier(2, 1);
-	quad->setRowBarrier(4, 6);
-	quad->setRowBarrier(6, 3);
-	quad->setRowBarrier(7, 7);
-
-	quad->setColBarrier(0, 4);
-	quad->setColBarrier(1, 3);
-	quad->setColBarrier(2, 6);
-	quad->setColBarrier(5, 2);
-	quad->setColBarrier(6, 4);
-	quad->setColBarrier(7, 7);
-
-}
-
-void createQuadrant5(Quadrant* quad) {
 
-	quad->setRowBarrier(0, 4);
-	quad->setRowBarrier(1, 6);
-	quad->setRowBarrier(3, 2);
-	quad->setRowBarrier(4, 5);
-	quad->setRowBarrier(5, 3);
-	quad->setRowBarrier(5, 8);
-	quad->setRowBarrier(7, 7);
-
-	quad->setColBarrier(0, 7);
-	quad->setColBarrier(1, 3);
-	quad->setColBarrier(2, 6);
-	quad->setColBarrier(5, 4);
-	quad->setColBarrier(6, 2);
-	quad->setColBarrier(7, 6);
-	quad->setColBarrier(7, 7);
+// robot indices of the diag colors, as in all_colors
+static constexpr int RED = 1;
+static constexpr int GREEN = 2;
 
+template <typename T, size_t N>
+static constexpr int countOf(const T (&)[N]) {
+	return N;
 }
 
-void createQuadrant6(Quadrant* quad) {
-
-	quad->setRowBarrier(0, 5);
-	quad->setRowBarrier(1, 3);
-	quad->setRowBarrier(3, 1);
-	quad->setRowBarrier(4, 6);
-	quad->setRowBarrier(6, 6);
-	quad->setRowBarrier(7, 4);
-	quad->setRowBarrier(7, 7);
-
-	quad->setColBarrier(0, 5);
-	quad->setColBarrier(1, 4);
-	quad->setColBarrier(2, 2);
-	quad->setColBarrier(3, 8);
-	quad->setColBarrier(5, 6);
-	quad->setColBarrier(6, 4);
-	quad->setColBarrier(7, 7);
-
-}
-
-
-void createQuadrant7(Quadrant* quad) {
 
-	quad->setRowBarrier(0, 5);
-	quad->setRowBarrier(1, 7);
-	quad->setRowBarrier(2, 1);
-	quad->setRowBarrier(5, 7);
-	quad->setRowBarrier(6, 3);
-	quad->setRowBarrier(7, 7);
+static constexpr QuadrantBarrier QUADRANT1_ROW_BARRIERS[] = {{0, 4}, {1, 1}, {2, 7}, {4, 3}, {5, 7}, {7, 7}};
+static constexpr QuadrantBarrier QUADRANT1_COL_BARRIERS[] = {{0, 6}, {1, 2}, {2, 5}, {6, 2}, {7, 5}, {7, 7}};
 
-	quad->setColBarrier(0, 6);
-	quad->setColBarrier(1, 2);
-	quad->setColBarrier(3, 7);
-	quad->setColBarrier(6, 2);
-	quad->setColBarrier(6, 5);
-	quad->setColBarrier(7, 7);
+static constexpr QuadrantBarrier QUADRANT2_ROW_BARRIERS[] = {{0, 4}, {2, 6}, {4, 3}, {5, 7}, {6, 1}, {7, 7}};
+static constexpr QuadrantBarrier QUADRANT2_COL_BARRIERS[] = {{0, 5}, {1, 6}, {2, 4}, {5, 3}, {7, 6}, {7, 7}};
 
-}
-
-void createQuadrant8(Quadrant* quad) {
-
-	quad->setRowBarrier(0, 2);
-	quad->setRowBarrier(1, 4);
-	quad->setRowBarrier(2, 2);
-	quad->setRowBarrier(3, 7);
-	quad->setRowBarrier(6, 3);
-	quad->setRowBarrier(7, 7);
-
-	quad->setColBarrier(0, 6);
-	quad->setColBarrier(1, 2);
-	quad->setColBarrier(3, 7);
-	quad->setColBarrier(4, 1);
-	quad->setColBarrier(6, 4);
-	quad->setColBarrier(7, 7);
-
-}
+static constexpr QuadrantBarrier QUADRANT3_ROW_BARRIERS[] = {{0, 5}, {1, 2}, {3, 6}, {5, 5}, {6, 2}, {7, 7}};
+static constexpr QuadrantBarrier QUADRANT3_COL_BARRIERS[] = {{0, 5}, {1, 7}, {2, 1}, {4, 5}, {6, 4}, {7, 7}};
 
+static constexpr QuadrantBarrier QUADRANT4_ROW_BARRIERS[] = {{0, 4}, {1, 6}, {2, 1}, {4, 6}, {6, 3}, {7, 7}};
+static constexpr QuadrantBarrier QUADRANT4_COL_BARRIERS[] = {{0, 4}, {1, 3}, {2, 6}, {5, 2}, {6, 4}, {7, 7}};
 
+static constexpr QuadrantBarrier QUADRANT5_ROW_BARRIERS[] = {{0, 4}, {1, 6}, {3, 2}, {4, 5}, {5, 3}, {5, 8}, {7, 7}};
+static constexpr QuadrantBarrier QUADRANT5_COL_BARRIERS[] = {{0, 7}, {1, 3}, {2, 6}, {5, 4}, {6, 2}, {7, 6}, {7, 7}};
 
+static constexpr QuadrantBarrier QUADRANT6_ROW_BARRIERS[] = {{0, 5}, {1, 3}, {3, 1}, {4, 6}, {6, 6}, {7, 4}, {7, 7}};
+static constexpr QuadrantBarrier QUADRANT6_COL_BARRIERS[] = {{0, 5}, {1, 4}, {2, 2}, {3, 8}, {5, 6}, {6, 4}, {7, 7}};
 
+static constexpr QuadrantBarrier QUADRANT7_ROW_BARRIERS[] = {{0, 5}, {1, 7}, {2, 1}, {5, 7}, {6, 3}, {7, 7}};
+static constexpr QuadrantBarrier QUADRANT7_COL_BARRIERS[] = {{0, 6}, {1, 2}, {3, 7}, {6, 2}, {6, 5}, {7, 7}};
 
-void createQuadrant9(Quadrant* quad) {
+static constexpr QuadrantBarrier QUADRANT8_ROW_BARRIERS[] = {{0, 2}, {1, 4}, {2, 2}, {3, 7}, {6, 3}, {7, 7}};
+static constexpr QuadrantBarrier QUADRANT8_COL_BARRIERS[] = {{0, 6}, {1, 2}, {3, 7}, {4, 1}, {6, 4}, {7, 7}};
 
-	quad->setRowBarrier(0, 5);
+static constexpr QuadrantBarrier QUADRANT9_ROW_BARRIERS[] = {{0, 5}, {2, 6}, {3, 3}, {5, 2}, {7, 6}, {7, 7}};
+static constexpr QuadrantBarrier QUADRANT9_COL_BARRIERS[] = {{0, 7}, {1, 6}, {2, 3}, {3, 4}, {6, 2}, {7, 7}};
+static constexpr QuadrantDiag QUADRANT9_DIAGS[] = {{1, 2, RED, false}, {6, 3, GREEN, false}};
 
-	quad->setRowBarrier(2, 6);
-	quad->setRowBarrier(3, 3);
+#define QUADRANT_WALLS(num) \
+	QUADRANT##num##_ROW_BARRIERS, countOf(QUADRANT##num##_ROW_BARRIERS), \
+	QUADRANT##num##_COL_BARRIERS, countOf(QUADRANT##num##_COL_BARRIERS)
 
-	quad->setRowBarrier(5, 2);
+// quadrants 10 .. 16 have no barriers of their own yet
+static constexpr QuadrantTable QUADRANT_TABLES[NUM_QUADRANTS] = {
+	{QUADRANT_WALLS(1), NULL, 0},
+	{QUADRANT_WALLS(2), NULL, 0},
+	{QUADRANT_WALLS(3), NULL, 0},
+	{QUADRANT_WALLS(4), NULL, 0},
+	{QUADRANT_WALLS(5), NULL, 0},
+	{QUADRANT_WALLS(6), NULL, 0},
+	{QUADRANT_WALLS(7), NULL, 0},
+	{QUADRANT_WALLS(8), NULL, 0},
+	{QUADRANT_WALLS(9), QUADRANT9_DIAGS, countOf(QUADRANT9_DIAGS)},
+	{NULL, 0, NULL, 0, NULL, 0},
+	{NULL, 0, NULL, 0, NULL, 0},
+	{NULL, 0, NULL, 0, NULL, 0},
+	{NULL, 0, NULL, 0, NULL, 0},
+	{NULL, 0, NULL, 0, NULL, 0},
+	{NULL, 0, NULL, 0, NULL, 0},
+	{NULL, 0, NULL, 0, NULL, 0},
+};
 
-	quad->setRowBarrier(7, 6); quad->setRowBarrier(7, 7);
+#undef QUADRANT_WALLS
 
-	
-
-	quad->setColBarrier(0, 7);
-	quad->setColBarrier(1, 6);
-	quad->setColBarrier(2, 3);
-	quad->setColBarrier(3, 4);
-
-
-	quad->setColBarrier(6, 2);
-	quad->setColBarrier(7, 7);
-
-	
-
-	quad->setDiagBarrier(1, 2, "red", false);
-	quad->setDiagBarrier(6, 3, "green", false);
 
+const QuadrantTable& getQuadrantTable(int quadrant_num) {
+	ASSERT(1 <= quadrant_num && quadrant_num <= NUM_QUADRANTS, "no quadrant " << quadrant_num);
+	return QUADRANT_TABLES[quadrant_num - 1];
 }
-
-
-
-
-Quadrant quadrant1(1);
-Quadrant quadrant2(2);
-Quadrant quadrant3(3);
-Quadrant quadrant4(4);
-
-Quadrant quadrant5(5);
-Quadrant quadrant6(6);
-Quadrant quadrant7(7);
-Quadrant quadrant8(8);
-
-Quadrant quadrant9(9);
-Quadrant quadrant10(10);
-Quadrant quadrant11(11);
-Quadrant quadrant12(12);
-
-Quadrant quadrant13(13);
-Quadrant quadrant14(14);
-Quadrant quadrant15(15);
-Quadrant quadrant16(16);
@@ -6,63 +6,41 @@
 
 using namespace std;
 
-class Quadrant;
-
 extern int QUADRANT_DIMENSION;
 
-extern Quadrant quadrant1;
-extern Quadrant quadrant2;
-extern Quadrant quadrant3;
-extern Quadrant quadrant4;
-
-extern Quadrant quadrant5;
-extern Quadrant quadrant6;
-extern Quadrant quadrant7;
-extern Quadrant quadrant8;
-
-extern Quadrant quadrant9;
-extern Quadrant quadrant10;
-extern Quadrant quadrant11;
-extern Quadrant quadrant12;
-
-extern Quadrant quadrant13;
-extern Quadrant quadrant14;
-extern Quadrant quadrant15;
-extern Quadrant quadrant16;
-
-class Quadrant : public Board {
-
-	vector<vector<int>> row_barriers; // row_barriers[i] contains the col indices of each row barrier (vertical) in row i
-	vector<vector<int>> col_barriers; // col_barriers[j] contains the row indices of each col barrier (horizontal) in row j
-	vector<vector<pair<int, DiagBarrier>>> diag_barriers; // diag_barriers[i][j] points to the diag barrier at position (i, j)
+const int NUM_QUADRANTS = 16;
 
-public:
-
-	// only sets default barriers on two edges
-	Quadrant(int quadrant_num, int quadrant_dimension=QUADRANT_DIMENSION);
+// a barrier in a quadrant's own coordinates, which put the center of the board at the bottom right.
+// for row barriers line is the row and index the col the barrier is to the west of,
+// for col barriers line is the col and index the row the barrier is to the north of
+struct QuadrantBarrier {
+	int line;
+	int index;
 };
 
+struct QuadrantDiag {
+	int row;
+	int col;
+	int robot; // color, as a robot index
+	bool is_forward;
+};
 
+// the barriers of one quadrant as compile time data. besides these, every quadrant has barriers
+// along its two outer edges
+struct QuadrantTable {
+	const QuadrantBarrier* row_barriers;
+	int num_row_barriers;
+	const QuadrantBarrier* col_barriers;
+	int num_col_barriers;
+	const QuadrantDiag* diags;
+	int num_diags;
+};
 
+// table for quadrant 1 .. 16
+const QuadrantTable& getQuadrantTable(int quadrant_num);
 
-void createQuadrant1(Quadrant* quad);
-void createQuadrant2(Quadrant* quad);
-void createQuadrant3(Quadrant* quad);
-void createQuadrant4(Quadrant* quad);
-
-void createQuadrant5(Quadrant* quad);
-void createQuadrant6(Quadrant* quad);
-void createQuadrant7(Quadrant* quad);
-void createQuadrant8(Quadrant* quad);
-
-void createQuadrant9(Quadrant* quad);
-void createQuadrant10(Quadrant* quad);
-void createQuadrant11(Quadrant* quad);
-void createQuadrant12(Quadrant* quad);
-
-void createQuadrant13(Quadrant* quad);
-void createQuadrant14(Quadrant* quad);
-void createQuadrant15(Quadrant* quad);
-void createQuadrant16(Quadrant* quad);
+// lays out quadrants top left, top right, bottom left, bottom right, straight from the quadrant tables,
+// and compiles the board
+void buildBoard(Board* board, int quadrant1, int quadrant2, int quadrant3, int quadrant4);
 
 #endif
@@ -2,7 +2,7 @@
 #include "board.h"
 
 #include <iostream>
-#include <cmath>
+#include <type_traits>
 
 using namespace std;
 
@@ -23,6 +23,8 @@ vector<Move> all_moves =
 		BLUE_NORTH, BLUE_SOUTH, BLUE_EAST, BLUE_WEST
 	};
 
+vector<string> all_colors = {"yellow", "red", "green", "blue"};
+
 string getColor(Move move) {
 	ASSERT(0 <= move && move < 16, "Move out of range");
 	if (move % NUM_ROBOTS == 0) {
@@ -57,6 +59,26 @@ string getDirection(Move move) {
 	ASSERT(false, "error in getDirection");
 }
 
+int getRobotIndex(Move move) {
+	DEBUG_ASSERT(0 <= move && move < 16, "Move out of range");
+	return move % NUM_ROBOTS;
+}
+
+int getRobotIndex(const string& color) {
+	for (int robot = 0; robot < NUM_ROBOTS; robot++) {
+		if (all_colors[robot] == color) {
+			return robot;
+		}
+	}
+	ASSERT(false, "unknown color " << color);
+	return -1;
+}
+
+int getDirectionIndex(Move move) {
+	DEBUG_ASSERT(0 <= move && move < 16, "Move out of range");
+	return move / NUM_ROBOTS;
+}
+
 void printMoves(const vector<Move>& moves) {
 	for (Move move : moves) {
 		cout << getColor(move) << ", " << getDirection(move) << endl;
@@ -159,34 +181,28 @@ bool RobotArrangement::isSolution(const Position& dest, const string& dest_color
 
 
 RobotArrangementEncoding encode(const RobotArrangement& robot_positions) {
+	ASSERT(BOARD_DIMENSION == COMPILED_DIMENSION, "encode needs a " << COMPILED_DIMENSION << " board");
+	return CompactArrangement(robot_positions).key();
+}
 
-	long yellow_pos = robot_positions.getRow("yellow") * BOARD_DIMENSION + robot_positions.getCol("yellow");
-	long red_pos = robot_positions.getRow("red") * BOARD_DIMENSION + robot_positions.getCol("red");
-	long green_pos = robot_positions.getRow("green") * BOARD_DIMENSION + robot_positions.getCol("green");
-	long blue_pos = robot_positions.getRow("blue") * BOARD_DIMENSION + robot_positions.getCol("blue");
-
-	vector<long> position_encodings = {yellow_pos, red_pos, green_pos, blue_pos};
-	long position_encoding = 0;
 
-	for (int i = 0; i < NUM_ROBOTS; i++) {
-		position_encoding += pow(BOARD_DIMENSION, 2*i) * position_encodings[i];
-	}
-	
-	long yellow_above_diag = robot_positions.getAboveDiag("yellow") ? 1 : 0;
-	long red_above_diag = robot_positions.getAboveDiag("red") ? 1 : 0;
-	long green_above_diag = robot_positions.getAboveDiag("green") ? 1 : 0;
-	long blue_above_diag = robot_positions.getAboveDiag("blue") ? 1 : 0;
 
-	vector<long> above_diag_encodings = {yellow_above_diag, red_above_diag, green_above_diag, blue_above_diag};
-	long final_encoding = pow(2, NUM_ROBOTS) * position_encoding;
+static_assert(is_trivially_copyable<CompactArrangement>::value && sizeof(CompactArrangement) == sizeof(uint64_t),
+	"CompactArrangement must stay a single trivially copyable word");
 
-	for (int i = 0; i < NUM_ROBOTS; i++) {
-		final_encoding += pow(2, i) * above_diag_encodings[i];
+CompactArrangement::CompactArrangement(const RobotArrangement& robot_positions) : packed(0) {
+	for (int robot = 0; robot < NUM_ROBOTS; robot++) {
+		const string& color = all_colors[robot];
+		this->setRobot(robot, cellOf(robot_positions.getRow(color), robot_positions.getCol(color)),
+			robot_positions.getAboveDiag(color));
 	}
-
-	return final_encoding;
-
 }
 
-
-
+RobotArrangement CompactArrangement::toRobotArrangement() const {
+	map<string, Position> robot_positions;
+	for (int robot = 0; robot < NUM_ROBOTS; robot++) {
+		int cell = this->getCell(robot);
+		robot_positions.insert(make_pair(all_colors[robot], Position(rowOf(cell), colOf(cell), this->getAboveDiag(robot))));
+	}
+	return RobotArrangement(robot_positions);
+}
@@ -6,6 +6,7 @@
 #include <tuple>
 #include <map>
 #include <set>
+#include <cstdint>
 
 using namespace std;
 
@@ -21,8 +22,28 @@ using namespace std;
         } \
     } while (false)
 
+/* DEBUG_ASSERT, for invariants checked on the hot path. compiled out under NDEBUG, which the optimized builds define. */
+
+#ifdef NDEBUG
+#   define DEBUG_ASSERT(condition, message) do { (void) sizeof(condition); } while (false)
+#else
+#   define DEBUG_ASSERT(condition, message) ASSERT(condition, message)
+#endif
+
 extern int NUM_ROBOTS;
 
+// compile time bound on NUM_ROBOTS, for per robot tables
+const int NUM_ROBOTS_MAX = 4;
+
+// the compiled board tables and compact arrangements are laid out for the standard 16x16 board
+const int COMPILED_DIMENSION = 16;
+const int NUM_CELLS = COMPILED_DIMENSION * COMPILED_DIMENSION;
+
+// cells are numbered row * COMPILED_DIMENSION + col
+inline int cellOf(int row, int col) { return row * COMPILED_DIMENSION + col; }
+inline int rowOf(int cell) { return cell / COMPILED_DIMENSION; }
+inline int colOf(int cell) { return cell % COMPILED_DIMENSION; }
+
 
 typedef int Move;
 extern Move YELLOW_NORTH, RED_NORTH, GREEN_NORTH, BLUE_NORTH;
@@ -30,9 +51,14 @@ extern Move YELLOW_SOUTH, RED_SOUTH, GREEN_SOUTH, BLUE_SOUTH;
 extern Move YELLOW_EAST, RED_EAST, GREEN_EAST, BLUE_EAST;
 extern Move YELLOW_WEST, RED_WEST, GREEN_WEST, BLUE_WEST;
 
+const int NUM_MOVES = 16;
 extern vector<Move> all_moves;
+extern vector<string> all_colors; // indexed by robot index, the same order as move % NUM_ROBOTS
 string getColor(Move move);
 string getDirection(Move move);
+int getRobotIndex(Move move);
+int getRobotIndex(const string& color);
+int getDirectionIndex(Move move);
 void printMoves(const vector<Move>& moves);
 
 
@@ -84,8 +110,82 @@ public:
 
 };
 
-typedef long RobotArrangementEncoding;
+// a CompactArrangement key, 36 bits wide, so every holder of one keeps all 64
+typedef uint64_t RobotArrangementEncoding;
 RobotArrangementEncoding encode(const RobotArrangement& robot_positions);
 
 
+// fixed size arrangement of the four robots, indexed by robot index rather than color.
+// the whole state lives in one word: bits 0-3 hold each robot's above diag bit,
+// and the 32 bits above them hold one cell byte per robot, yellow lowest.
+// that is the same value encode() gives, so the word doubles as the state key.
+// the key is 36 bits rather than 32: a robot resting on a diag cell can be on either side of the diag,
+// and the side decides where its next move goes, so the four cell bytes alone do not name a state.
+// off the diags the side bit means nothing. RobotArrangement and setRobot keep whatever they are given (Position
+// defaults it to true), so searches start from Board::normalized, and moves clear the bit of a robot that stops
+// off a diag. keys from either are clear off the diags, which is why VisitedTable indexes by key() >> 4,
+// a 32 bit index, and why every table keyed on the whole key sees one board state as one key
+class CompactArrangement {
+
+	uint64_t packed;
+
+public:
+
+	CompactArrangement() : packed(0) {}
+	explicit CompactArrangement(const RobotArrangement& robot_positions);
+
+	int getCell(int robot) const { return (this->packed >> (4 + 8 * robot)) & 0xff; }
+	bool getAboveDiag(int robot) const { return (this->packed >> robot) & 1; }
+
+	void setRobot(int robot, int cell, bool above_diag) {
+		this->packed &= ~((uint64_t(0xff) << (4 + 8 * robot)) | (uint64_t(1) << robot));
+		this->packed |= (uint64_t(cell) << (4 + 8 * robot)) | (uint64_t(above_diag) << robot);
+	}
+
+	// returns whether the robot of index dest_robot is on dest_cell
+	bool isSolution(int dest_cell, int dest_robot) const { return this->getCell(dest_robot) == dest_cell; }
+
+	// packed key of this arrangement, equal to encode() of the matching RobotArrangement
+	RobotArrangementEncoding key() const { return this->packed; }
+
+	// the arrangement a key() came from
+	static CompactArrangement fromKey(RobotArrangementEncoding key) {
+		CompactArrangement robot_positions;
+		robot_positions.packed = key;
+		return robot_positions;
+	}
+
+	// representative of the arrangements that only differ by swapping the robots in the
+	// interchangeable_robots bitmask: their (cell, above diag) pairs are sorted into robot index order
+	CompactArrangement canonical(int interchangeable_robots) const {
+		if (interchangeable_robots == 0) {
+			return *this;
+		}
+
+		int robots[NUM_ROBOTS_MAX];
+		int values[NUM_ROBOTS_MAX];
+		int num_robots = 0;
+		for (int robot = 0; robot < NUM_ROBOTS_MAX; robot++) {
+			if (interchangeable_robots & (1 << robot)) {
+				int value = (this->getCell(robot) << 1) | this->getAboveDiag(robot);
+				int i = num_robots++;
+				for (; i > 0 && values[i - 1] > value; i--) {
+					values[i] = values[i - 1];
+				}
+				values[i] = value;
+				robots[num_robots - 1] = robot;
+			}
+		}
+
+		CompactArrangement result = *this;
+		for (int i = 0; i < num_robots; i++) {
+			result.setRobot(robots[i], values[i] >> 1, values[i] & 1);
+		}
+		return result;
+	}
+
+	RobotArrangement toRobotArrangement() const;
+};
+
+
 #endif
\ No newline at end of file
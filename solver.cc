@@ -1,10 +1,15 @@
 #include "solver.h"
+#include "parallel.h"
 #include <iostream>
+#include <algorithm>
+#include <chrono>
 #include <time.h>
 
 using namespace std;
 
 int DEFAULT_MAX_DEPTH = 20;
+int DEFAULT_ALL_TARGETS_DEPTH = 11;
+size_t SEARCH_MEMORY_LIMIT = 0;
 
 void log(string msg) {
 	cout << msg << " -  ";
@@ -19,87 +24,532 @@ void log(string msg) {
 
 }
 
-int solveRicochetBoard(const Board& board, const RobotArrangement& robot_positions, const Position& dest,
-	const string& dest_color, vector<Move>* moves, int max_depth) {
+static double secondsSince(chrono::steady_clock::time_point start) {
+	return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+// a bounded table keeps what each pass touched ahead of what earlier passes left behind
+static void startPass(VisitedTable*) {}
+
+static void startPass(BoundedVisitedTable* visited_depths) {
+	visited_depths->newGeneration();
+}
 
-	map<RobotArrangementEncoding, int> visited_depths;
+// the passes of the iterative deepening, solveRicochetBoard wraps them with the choice of table and the stats
+template <class Table>
+static int iterativeDeepening(const Board& board, const CompactArrangement& start, int dest_cell, int dest_robot,
+	vector<Move>* moves, int max_depth, Table* visited_depths, SolverStats* stats) {
 
-	for (int depth_limit = 0; depth_limit < max_depth; depth_limit++) {
-		log("Looking for solutions at depth " + to_string(depth_limit));
+	const vector<uint8_t>* distance_map = board.isCompiled() ? &board.getDistanceMap(dest_cell, dest_robot) : NULL;
 
-		int solution_length = solveDepthLimitedDfs(board, robot_positions, dest, dest_color, moves, &visited_depths, 0, depth_limit);
-		bool solved = solution_length != -1;
+	int solution_length = -1;
+	for (int depth_limit = 0; depth_limit < max_depth && solution_length == -1; depth_limit++) {
+		chrono::steady_clock::time_point depth_start = chrono::steady_clock::now();
+		DepthStats* depth_stats = stats != NULL ? stats->startDepth(depth_limit) : NULL;
+
+		startPass(visited_depths);
+		bool solved = solveDepthLimitedDfs(board, start, dest_cell, dest_robot, moves, visited_depths, 0, depth_limit,
+			distance_map, depth_stats) != -1;
 		if (solved) {
-			return depth_limit;
+			solution_length = depth_limit;
+		}
+		if (depth_stats != NULL) {
+			depth_stats->seconds = secondsSince(depth_start);
 		}
 	}
+	return solution_length;
+}
 
-	return -1;
+int solveRicochetBoard(const Board& board, const RobotArrangement& robot_positions, const Position& dest,
+	const string& dest_color, vector<Move>* moves, int max_depth, SolverStats* stats) {
+
+	chrono::steady_clock::time_point solve_start = chrono::steady_clock::now();
+	if (stats != NULL) {
+		stats->start("iterative_deepening");
+	}
+
+	CompactArrangement start = board.normalized(CompactArrangement(robot_positions));
+	int dest_cell = cellOf(dest.getRow(), dest.getCol());
+	int dest_robot = getRobotIndex(dest_color);
+
+	int solution_length;
+	long visited_states;
+	size_t visited_bytes;
+	long evictions = 0;
+	if (SEARCH_MEMORY_LIMIT > 0) {
+		BoundedVisitedTable visited_depths(SEARCH_MEMORY_LIMIT);
+		solution_length = iterativeDeepening(board, start, dest_cell, dest_robot, moves, max_depth, &visited_depths, stats);
+		visited_states = visited_depths.size();
+		visited_bytes = visited_depths.bytes();
+		evictions = visited_depths.getEvictions();
+	} else {
+		VisitedTable visited_depths(board);
+		solution_length = iterativeDeepening(board, start, dest_cell, dest_robot, moves, max_depth, &visited_depths, stats);
+		visited_states = visited_depths.size();
+		// walks the page table, so only when asked
+		visited_bytes = stats != NULL ? visited_depths.bytes() : 0;
+	}
+
+	if (stats != NULL) {
+		stats->solution_length = solution_length;
+		stats->visited_states = visited_states;
+		stats->evictions = evictions;
+		stats->seconds = secondsSince(solve_start);
+		stats->visited_bytes = visited_bytes;
+	}
+	return solution_length;
 }
 
 
-// map should hold how many steps were left when we visited this previously
-bool worthExpanding(const RobotArrangement& robot_positions, 
-	map<RobotArrangementEncoding, int>* visited_depths, int depth, int max_depth) {
+int solveRicochetBoard(const Board& board, const RobotArrangement& robot_positions, const Position& dest,
+	const string& dest_color, vector<vector<Move>>* solutions, int num_sols, SearchAlgorithm algorithm,
+	int max_depth, SolverStats* stats) {
 
-	RobotArrangementEncoding encoding = encode(robot_positions);
-	int num_steps_left = max_depth - depth;
+	if (algorithm == BREADTH_FIRST) {
+		return solveRicochetBoardBfs(board, robot_positions, dest, dest_color, solutions, num_sols, max_depth, stats);
+	}
 
-	// if never been here, add it to map and return true
-	if (visited_depths->count(encoding) == 0) {
-		visited_depths->insert(make_pair(encoding, num_steps_left));
-		return true;
+	vector<Move> moves;
+	int solution_length;
+	if (algorithm == IDA_STAR) {
+		solution_length = solveRicochetBoardIdaStar(board, robot_positions, dest, dest_color, &moves, max_depth, stats);
+	} else if (algorithm == PARALLEL_BREADTH_FIRST) {
+		solution_length = solveRicochetBoardParallel(board, robot_positions, dest, dest_color, &moves,
+			PARALLEL_SEARCH_THREADS, max_depth, stats);
 	} else {
-		// if visited already at an earlier depth, no point
-		int prev_num_steps_left = visited_depths->at(encoding);
-		if (prev_num_steps_left >= num_steps_left) {
-			return false;
-		} else {
-			// if visited before, but at a deeper depth, might still be worth
-			visited_depths->at(encoding) = num_steps_left;
-			return true;
+		solution_length = solveRicochetBoard(board, robot_positions, dest, dest_color, &moves, max_depth, stats);
+	}
+	if (solution_length != -1 && num_sols > 0) {
+		solutions->push_back(moves);
+	}
+	return solution_length;
+}
+
+
+// one expanded state of the bfs, with how it was reached
+struct BfsNode {
+	CompactArrangement robot_positions;
+	int parent; // index into the node list, -1 for the start
+	Move move; // move made from the parent
+};
+
+// walks the parent pointers back from the given node
+static vector<Move> bfsPath(const vector<BfsNode>& nodes, int node) {
+	vector<Move> moves;
+	for (; nodes[node].parent != -1; node = nodes[node].parent) {
+		moves.push_back(nodes[node].move);
+	}
+	reverse(moves.begin(), moves.end());
+	return moves;
+}
+
+// the bfs proper, solveRicochetBoardBfs wraps it with the stats bookkeeping
+static int breadthFirstSearch(const Board& board, const CompactArrangement& start, int dest_cell, int dest_robot,
+	vector<vector<Move>>* solutions, int num_sols, int max_depth, VisitedTable* visited, SolverStats* stats) {
+
+	int num_found = 0;
+	if (start.isSolution(dest_cell, dest_robot)) {
+		solutions->push_back(vector<Move>());
+		return 0;
+	}
+
+	// states are deduplicated up to swapping interchangeable helpers
+	int interchangeable_robots = board.getInterchangeableRobots(dest_robot);
+	vector<BfsNode> nodes;
+	nodes.push_back({start, -1, -1});
+	visited->insert(start.canonical(interchangeable_robots));
+
+	// nodes[layer_begin, layer_end) all sit at the given depth
+	int layer_begin = 0;
+	int layer_end = 1;
+	for (int depth = 0; depth + 1 < max_depth && layer_begin < layer_end; depth++) {
+		chrono::steady_clock::time_point layer_start = chrono::steady_clock::now();
+		DepthStats* layer_stats = stats != NULL ? stats->startDepth(depth) : NULL;
+
+		for (int node = layer_begin; node < layer_end; node++) {
+			CompactArrangement parent_positions = nodes[node].robot_positions;
+
+			// make every move first, so the visited entries of the children are fetched together
+			CompactArrangement children[NUM_MOVES];
+			CompactArrangement canonical_children[NUM_MOVES];
+			Move child_moves[NUM_MOVES];
+			int num_children = board.generateChildren(parent_positions, children, child_moves);
+			for (int child = 0; child < num_children; child++) {
+				canonical_children[child] = children[child].canonical(interchangeable_robots);
+			}
+			visited->prefetch(canonical_children, num_children);
+			if (layer_stats != NULL) {
+				layer_stats->nodes_expanded++;
+				layer_stats->nodes_generated += num_children;
+			}
+
+			for (int child = 0; child < num_children; child++) {
+				const CompactArrangement& new_robot_positions = children[child];
+				Move move = child_moves[child];
+
+				// solutions are never expanded further, so each (parent, move) into dest is a distinct path
+				if (new_robot_positions.isSolution(dest_cell, dest_robot)) {
+					vector<Move> moves = bfsPath(nodes, node);
+					moves.push_back(move);
+					solutions->push_back(moves);
+					num_found++;
+					if (num_found == num_sols) {
+						if (layer_stats != NULL) {
+							layer_stats->seconds = secondsSince(layer_start);
+						}
+						return solutions->at(solutions->size() - num_found).size();
+					}
+					continue;
+				}
+
+				if (visited->insert(canonical_children[child])) {
+					nodes.push_back({new_robot_positions, node, move});
+				} else if (layer_stats != NULL) {
+					layer_stats->duplicate_hits++;
+				}
+			}
+		}
+
+		if (layer_stats != NULL) {
+			layer_stats->seconds = secondsSince(layer_start);
+		}
+		layer_begin = layer_end;
+		layer_end = nodes.size();
+	}
+
+	return num_found > 0 ? solutions->at(solutions->size() - num_found).size() : -1;
+}
+
+int solveRicochetBoardBfs(const Board& board, const RobotArrangement& robot_positions, const Position& dest,
+	const string& dest_color, vector<vector<Move>>* solutions, int num_sols, int max_depth, SolverStats* stats) {
+
+	ASSERT(solutions != NULL, "cannot collect solutions into a null vector");
+	ASSERT(num_sols >= 0 && max_depth >= 0, "Cannot have a negative number of solutions or max depth");
+	chrono::steady_clock::time_point solve_start = chrono::steady_clock::now();
+	if (stats != NULL) {
+		stats->start("breadth_first");
+	}
+	if (num_sols == 0) {
+		return -1;
+	}
+
+	VisitedTable visited(board);
+	int solution_length = breadthFirstSearch(board, board.normalized(CompactArrangement(robot_positions)),
+		cellOf(dest.getRow(), dest.getCol()), getRobotIndex(dest_color), solutions, num_sols, max_depth, &visited, stats);
+
+	if (stats != NULL) {
+		stats->solution_length = solution_length;
+		stats->visited_states = visited.size();
+		stats->seconds = secondsSince(solve_start);
+		stats->visited_bytes = visited.bytes();
+	}
+	return solution_length;
+}
+
+
+AllTargetsSolution::AllTargetsSolution() : lengths(NUM_ROBOTS_MAX * NUM_CELLS, -1),
+	witnesses(NUM_ROBOTS_MAX * NUM_CELLS) {}
+
+void AllTargetsSolution::setSolution(int dest_cell, int dest_robot, const vector<Move>& moves) {
+	this->lengths[dest_robot * NUM_CELLS + dest_cell] = moves.size();
+	this->witnesses[dest_robot * NUM_CELLS + dest_cell] = moves;
+}
+
+int AllTargetsSolution::getLength(int dest_cell, int dest_robot) const {
+	return this->lengths[dest_robot * NUM_CELLS + dest_cell];
+}
+
+int AllTargetsSolution::getSolution(const Position& dest, const string& dest_color, vector<Move>* moves) const {
+	int index = getRobotIndex(dest_color) * NUM_CELLS + cellOf(dest.getRow(), dest.getCol());
+	if (this->lengths[index] != -1 && moves != NULL) {
+		*moves = this->witnesses[index];
+	}
+	return this->lengths[index];
+}
+
+int AllTargetsSolution::numSolved() const {
+	return NUM_CELLS * NUM_ROBOTS_MAX - count(this->lengths.begin(), this->lengths.end(), -1);
+}
+
+
+void solveAllTargets(const Board& board, const RobotArrangement& robot_positions, AllTargetsSolution* solution,
+	int max_depth) {
+
+	ASSERT(solution != NULL, "cannot fill a null solution");
+	*solution = AllTargetsSolution();
+
+	// first node at which each (robot, cell) was reached, turned into paths once the search is over
+	vector<int> first_nodes(NUM_ROBOTS_MAX * NUM_CELLS, -1);
+	int num_reached = 0;
+
+	// no helper symmetry here, every robot is a possible target
+	CompactArrangement start = board.normalized(CompactArrangement(robot_positions));
+	vector<BfsNode> nodes;
+	VisitedTable visited(board);
+	nodes.push_back({start, -1, -1});
+	visited.insert(start);
+
+	int layer_begin = 0;
+	int layer_end = 1;
+	for (int depth = 0; layer_begin < layer_end; depth++) {
+
+		// record what this layer reaches for the first time
+		for (int node = layer_begin; node < layer_end; node++) {
+			for (int robot = 0; robot < NUM_ROBOTS; robot++) {
+				int& first_node = first_nodes[robot * NUM_CELLS + nodes[node].robot_positions.getCell(robot)];
+				if (first_node == -1) {
+					first_node = node;
+					num_reached++;
+				}
+			}
+		}
+
+		if (depth + 1 >= max_depth || num_reached == NUM_ROBOTS * NUM_CELLS) {
+			break;
+		}
+
+		for (int node = layer_begin; node < layer_end; node++) {
+			CompactArrangement parent_positions = nodes[node].robot_positions;
+
+			CompactArrangement children[NUM_MOVES];
+			Move child_moves[NUM_MOVES];
+			int num_children = board.generateChildren(parent_positions, children, child_moves);
+			visited.prefetch(children, num_children);
+
+			for (int child = 0; child < num_children; child++) {
+				if (visited.insert(children[child])) {
+					nodes.push_back({children[child], node, child_moves[child]});
+				}
+			}
+		}
+
+		layer_begin = layer_end;
+		layer_end = nodes.size();
+	}
+
+	for (int robot = 0; robot < NUM_ROBOTS; robot++) {
+		for (int cell = 0; cell < NUM_CELLS; cell++) {
+			int first_node = first_nodes[robot * NUM_CELLS + cell];
+			if (first_node != -1) {
+				solution->setSolution(cell, robot, bfsPath(nodes, first_node));
+			}
+		}
+	}
+}
+
+
+// state shared by every node of one IDA* pass
+struct IdaStarSearch {
+	const Board* board;
+	int dest_cell;
+	int dest_robot;
+	int interchangeable_robots; // table keys are canonical up to swapping these
+	const vector<uint8_t>* distance_map; // NULL on uncompiled boards
+	TranspositionTable* table;
+	vector<Move>* moves;
+	int threshold;
+	DepthStats* stats; // NULL unless counting
+};
+
+// returns the solution length if one fits under the threshold, otherwise -1 with min_exceeding
+// set to the smallest f beyond the threshold seen below this node
+static int idaStarDfs(IdaStarSearch* search, const CompactArrangement& robot_positions, int depth, int* min_exceeding) {
+	// without a distance map a node on the threshold is expanded, so a solution can turn up one move past it.
+	// it only counts from a later pass, after every shorter one has been ruled out
+	if (robot_positions.isSolution(search->dest_cell, search->dest_robot)) {
+		if (depth > search->threshold) {
+			*min_exceeding = depth;
+			return -1;
+		}
+		return depth;
+	}
+
+	CompactArrangement canonical_positions = robot_positions.canonical(search->interchangeable_robots);
+	int lower_bound = search->table->getLowerBound(canonical_positions);
+	if (search->distance_map != NULL) {
+		lower_bound = max(lower_bound, int((*search->distance_map)[robot_positions.getCell(search->dest_robot)]));
+	}
+	if (depth + lower_bound > search->threshold) {
+		if (search->stats != NULL) {
+			search->stats->nodes_pruned++;
+		}
+		*min_exceeding = depth + lower_bound;
+		return -1;
+	}
+
+	if (search->stats != NULL) {
+		search->stats->nodes_expanded++;
+	}
+	CompactArrangement children[NUM_MOVES];
+	Move child_moves[NUM_MOVES];
+	int num_children = search->board->generateChildren(robot_positions, children, child_moves);
+	if (search->stats != NULL) {
+		search->stats->nodes_generated += num_children;
+	}
+
+	int subtree_min = UNREACHABLE_DISTANCE + depth;
+	for (int child = 0; child < num_children; child++) {
+		search->moves->push_back(child_moves[child]);
+		int child_min = UNREACHABLE_DISTANCE + depth;
+		int solution_length = idaStarDfs(search, children[child], depth + 1, &child_min);
+		if (solution_length != -1) {
+			return solution_length;
+		}
+		search->moves->pop_back();
+		subtree_min = min(subtree_min, child_min);
+	}
+
+	// nothing under here fits the threshold, so at least subtree_min - depth moves are left from here
+	search->table->setLowerBound(canonical_positions, subtree_min - depth);
+	*min_exceeding = subtree_min;
+	return -1;
+}
+
+int solveRicochetBoardIdaStar(const Board& board, const RobotArrangement& robot_positions, const Position& dest,
+	const string& dest_color, vector<Move>* moves, int max_depth, SolverStats* stats, size_t table_entries) {
+
+	ASSERT(moves != NULL, "cannot write moves into a null vector");
+	chrono::steady_clock::time_point solve_start = chrono::steady_clock::now();
+	if (stats != NULL) {
+		stats->start("ida_star");
+	}
+	if (SEARCH_MEMORY_LIMIT > 0) {
+		table_entries = min(table_entries, SEARCH_MEMORY_LIMIT / sizeof(uint64_t));
+	}
+	TranspositionTable table(table_entries);
+	CompactArrangement start = board.normalized(CompactArrangement(robot_positions));
+
+	IdaStarSearch search;
+	search.board = &board;
+	search.dest_cell = cellOf(dest.getRow(), dest.getCol());
+	search.dest_robot = getRobotIndex(dest_color);
+	search.interchangeable_robots = board.getInterchangeableRobots(search.dest_robot);
+	search.distance_map = board.isCompiled() ? &board.getDistanceMap(search.dest_cell, search.dest_robot) : NULL;
+	search.table = &table;
+	search.moves = moves;
+	search.threshold = 0;
+
+	int solution_length = -1;
+	while (search.threshold < max_depth) {
+		chrono::steady_clock::time_point pass_start = chrono::steady_clock::now();
+		search.stats = stats != NULL ? stats->startDepth(search.threshold) : NULL;
+		moves->clear();
+		int next_threshold = UNREACHABLE_DISTANCE;
+		solution_length = idaStarDfs(&search, start, 0, &next_threshold);
+		if (search.stats != NULL) {
+			search.stats->seconds = secondsSince(pass_start);
 		}
 
+		if (solution_length != -1 || next_threshold >= UNREACHABLE_DISTANCE) {
+			break; // solved, or the target cannot be reached at all
+		}
+		search.threshold = next_threshold;
+	}
+
+	if (solution_length == -1) {
+		moves->clear();
 	}
+	if (stats != NULL) {
+		stats->solution_length = solution_length;
+		stats->evictions = table.getEvictions();
+		stats->seconds = secondsSince(solve_start);
+		stats->visited_bytes = table.bytes();
+	}
+	return solution_length;
+}
+
+
+// table should hold how many steps were left when we visited this previously
+bool worthExpanding(const CompactArrangement& robot_positions, 
+	VisitedTable* visited_depths, int depth, int max_depth) {
+
+	// if visited already with as many steps left, no point.
+	// otherwise record the steps we have now, a never visited arrangement always qualifies
+	int num_steps_left = max_depth - depth;
+	return visited_depths->raiseStepsLeft(robot_positions, num_steps_left);
+}
+
+bool worthExpanding(const CompactArrangement& robot_positions,
+	BoundedVisitedTable* visited_depths, int depth, int max_depth) {
 
-	return false;
+	return visited_depths->raiseStepsLeft(robot_positions, max_depth - depth);
 }
 
 
-int solveDepthLimitedDfs(const Board& board, const RobotArrangement& robot_positions, const Position& dest,
-	const string& dest_color, vector<Move>* moves,
-	map<RobotArrangementEncoding, int>* visited_depths, int depth, int max_depth) {
+// the depth limited dfs over either kind of visited table
+template <class Table>
+static int depthLimitedDfs(const Board& board, const CompactArrangement& robot_positions, int dest_cell,
+	int dest_robot, vector<Move>* moves,
+	Table* visited_depths, int depth, int max_depth, const vector<uint8_t>* distance_map, DepthStats* stats) {
 
 	if (depth > max_depth) {
 		return -1;
 	}
 
-	if (robot_positions.isSolution(dest, dest_color)) {
+	if (robot_positions.isSolution(dest_cell, dest_robot)) {
 		return depth; // assume the move to get here was already appended to moves
 	}
 
-	// determine if worth expanding based on if we've seen this before
-	bool worth_expanding = worthExpanding(robot_positions, visited_depths, depth, max_depth);
+	// the target robot alone still needs at least this many moves, however the others help it
+	if (distance_map != NULL && depth + (*distance_map)[robot_positions.getCell(dest_robot)] > max_depth) {
+		if (stats != NULL) {
+			stats->nodes_pruned++;
+		}
+		return -1;
+	}
+
+	// determine if worth expanding based on if we've seen this, or a swap of its interchangeable helpers, before
+	int interchangeable_robots = board.getInterchangeableRobots(dest_robot);
+	bool worth_expanding = worthExpanding(robot_positions.canonical(interchangeable_robots), visited_depths,
+		depth, max_depth);
 	if (!worth_expanding) {
+		if (stats != NULL) {
+			stats->duplicate_hits++;
+		}
 		return -1;
 	}
 
+	// make every move first, so the visited entries of the children are fetched together
+	CompactArrangement children[NUM_MOVES];
+	CompactArrangement canonical_children[NUM_MOVES];
+	Move child_moves[NUM_MOVES];
+	int num_children = board.generateChildren(robot_positions, children, child_moves);
+	for (int child = 0; child < num_children; child++) {
+		canonical_children[child] = children[child].canonical(interchangeable_robots);
+	}
+	visited_depths->prefetch(canonical_children, num_children);
+	if (stats != NULL) {
+		stats->nodes_expanded++;
+		stats->nodes_generated += num_children;
+	}
 
-	for (Move move : all_moves) {
-		RobotArrangement new_robot_positions(robot_positions);
-		bool piece_moves = board.makeMove(move, &new_robot_positions); // updates new_robot_positions according to the new move
-		if (piece_moves) {
-			moves->push_back(move);
-			int solution_length = solveDepthLimitedDfs(board, new_robot_positions, dest, dest_color, moves, visited_depths,
-				depth + 1, max_depth);
-			bool is_solution = solution_length != -1;
-			if (is_solution) {
-				return solution_length;
-			} else {
-				moves->pop_back();
-			}
+	for (int child = 0; child < num_children; child++) {
+		moves->push_back(child_moves[child]);
+		int solution_length = depthLimitedDfs(board, children[child], dest_cell, dest_robot, moves, visited_depths,
+			depth + 1, max_depth, distance_map, stats);
+		bool is_solution = solution_length != -1;
+		if (is_solution) {
+			return solution_length;
+		} else {
+			moves->pop_back();
 		}
 	}
 
 	return -1;
-}
\ No newline at end of file
+}
+
+int solveDepthLimitedDfs(const Board& board, const CompactArrangement& robot_positions, int dest_cell,
+	int dest_robot, vector<Move>* moves,
+	VisitedTable* visited_depths, int depth, int max_depth, const vector<uint8_t>* distance_map, DepthStats* stats) {
+
+	return depthLimitedDfs(board, robot_positions, dest_cell, dest_robot, moves, visited_depths, depth, max_depth,
+		distance_map, stats);
+}
+
+int solveDepthLimitedDfs(const Board& board, const CompactArrangement& robot_positions, int dest_cell,
+	int dest_robot, vector<Move>* moves,
+	BoundedVisitedTable* visited_depths, int depth, int max_depth, const vector<uint8_t>* distance_map, DepthStats* stats) {
+
+	return depthLimitedDfs(board, robot_positions, dest_cell, dest_robot, moves, visited_depths, depth, max_depth,
+		distance_map, stats);
+}
@@ -3,28 +3,98 @@
 
 #include "robots.h"
 #include "board.h"
+#include "visited.h"
+#include "transposition.h"
+#include "stats.h"
 
 using namespace std;
 
 extern int DEFAULT_MAX_DEPTH;
+extern int DEFAULT_ALL_TARGETS_DEPTH; // the all targets search cannot stop at a goal, so looks less deep by default
+
+// bytes each iterative deepening or IDA* solve may spend on its table, 0 for no limit.
+// with a limit, iterative deepening records its visits in a BoundedVisitedTable instead of a VisitedTable
+extern size_t SEARCH_MEMORY_LIMIT;
+
+// PARALLEL_BREADTH_FIRST is solveRicochetBoardParallel (see parallel.h) on PARALLEL_SEARCH_THREADS threads
+enum SearchAlgorithm { ITERATIVE_DEEPENING, BREADTH_FIRST, IDA_STAR, PARALLEL_BREADTH_FIRST };
 
 // logs message with timestamp
 void log(string msg);
 
-// iteratively runs depth limited dfs, incrementing depth each time
+// iteratively runs depth limited dfs, incrementing depth each time.
+// every solve takes an optional stats, which gets one DepthStats per depth limit (or layer, or threshold)
+int solveRicochetBoard(const Board& board, const RobotArrangement& robot_positions, const Position& dest,
+	const string& dest_color, vector<Move>* moves, int max_depth=DEFAULT_MAX_DEPTH, SolverStats* stats=NULL);
+
+// runs the chosen search and fills solutions with up to num_sols distinct move lists, shortest first.
+// only the breadth first search finds more than one solution. returns the shortest solution length, or -1
 int solveRicochetBoard(const Board& board, const RobotArrangement& robot_positions, const Position& dest,
-	const string& dest_color, vector<Move>* moves, int max_depth=DEFAULT_MAX_DEPTH);
+	const string& dest_color, vector<vector<Move>>* solutions, int num_sols, SearchAlgorithm algorithm,
+	int max_depth=DEFAULT_MAX_DEPTH, SolverStats* stats=NULL);
+
+// layered breadth first search over packed states, keeping a parent pointer and move per state to rebuild paths.
+// every move that lands the robot on dest yields a distinct solution, collected in order of length
+// until there are num_sols of them. like the iterative deepening, only finds solutions shorter than max_depth
+int solveRicochetBoardBfs(const Board& board, const RobotArrangement& robot_positions, const Position& dest,
+	const string& dest_color, vector<vector<Move>>* solutions, int num_sols=1, int max_depth=DEFAULT_MAX_DEPTH,
+	SolverStats* stats=NULL);
+
+// IDA*: depth first passes bounded by f = depth + lower bound, the bound coming from the distance map
+// and from a transposition table of bounds proven by earlier passes. each pass raises the threshold to the
+// smallest f that went over it, rather than by one. memory is the fixed size table, however deep the puzzle.
+// finds optimal solutions shorter than max_depth
+int solveRicochetBoardIdaStar(const Board& board, const RobotArrangement& robot_positions, const Position& dest,
+	const string& dest_color, vector<Move>* moves, int max_depth=DEFAULT_MAX_DEPTH,
+	SolverStats* stats=NULL, size_t table_entries=DEFAULT_TABLE_ENTRIES);
+
+// shortest solution for every target chip and robot color, for one starting arrangement
+class AllTargetsSolution {
+
+	vector<int> lengths; // indexed by robot * NUM_CELLS + cell, -1 if not reached
+	vector<vector<Move>> witnesses; // one shortest move list per reached (robot, cell)
+
+public:
+
+	AllTargetsSolution();
+
+	void setSolution(int dest_cell, int dest_robot, const vector<Move>& moves);
+
+	// length of the shortest solution moving the robot of index dest_robot onto dest_cell, -1 if none was found
+	int getLength(int dest_cell, int dest_robot) const;
+
+	// same, and copies one shortest move list into moves
+	int getSolution(const Position& dest, const string& dest_color, vector<Move>* moves) const;
+
+	// number of (robot, cell) pairs with a solution
+	int numSolved() const;
+};
+
+// one breadth first search outward from robot_positions that records, for every robot and cell,
+// the first depth at which that robot lands there and a witness path. answers every target chip of a round
+// at once, for solutions shorter than max_depth. stops early once every pair has been reached
+void solveAllTargets(const Board& board, const RobotArrangement& robot_positions, AllTargetsSolution* solution,
+	int max_depth=DEFAULT_ALL_TARGETS_DEPTH);
 
 // returns true if there is a solution of (max_depth - depth) fewer moves,
-// starting at robot_positions, and getting the given robot to DEST.
-// if true, the vector Moves will contain all the moves, if false, could be anything
-int solveDepthLimitedDfs(const Board& board, const RobotArrangement& robot_positions, const Position& dest,
-	const string& dest_color, vector<Move>* moves, map<RobotArrangementEncoding, int>* visited_depths,
-	int depth=0, int max_depth=DEFAULT_MAX_DEPTH);
+// starting at robot_positions, and getting the robot of index dest_robot to dest_cell.
+// if true, the vector Moves will contain all the moves, if false, could be anything.
+// with a distance map (see Board::getDistanceMap), prunes every node where depth + distance > max_depth.
+// if given, stats counts the nodes of this pass
+int solveDepthLimitedDfs(const Board& board, const CompactArrangement& robot_positions, int dest_cell,
+	int dest_robot, vector<Move>* moves, VisitedTable* visited_depths,
+	int depth=0, int max_depth=DEFAULT_MAX_DEPTH, const vector<uint8_t>* distance_map=NULL, DepthStats* stats=NULL);
+
+// same, recording visits in a table of fixed size
+int solveDepthLimitedDfs(const Board& board, const CompactArrangement& robot_positions, int dest_cell,
+	int dest_robot, vector<Move>* moves, BoundedVisitedTable* visited_depths,
+	int depth=0, int max_depth=DEFAULT_MAX_DEPTH, const vector<uint8_t>* distance_map=NULL, DepthStats* stats=NULL);
 
 // helper function. returns true if this arrangement hasnt been seen
 // or, when previously seen, it wasn't expanded to the depth that it will be now
-bool worthExpanding(const RobotArrangement& robot_positions, 
-	map<RobotArrangementEncoding, int>* visited_depths, int depth, int max_depth);
+bool worthExpanding(const CompactArrangement& robot_positions, 
+	VisitedTable* visited_depths, int depth, int max_depth);
+bool worthExpanding(const CompactArrangement& robot_positions,
+	BoundedVisitedTable* visited_depths, int depth, int max_depth);
 
 #endif
\ No newline at end of file
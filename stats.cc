@@ -0,0 +1,167 @@
+#include "stats.h"
+
+#include <sstream>
+#include <cmath>
+
+using namespace std;
+
+
+SolverStats::SolverStats() {
+	this->start("");
+}
+
+void SolverStats::start(const string& algorithm) {
+	this->algorithm = algorithm;
+	this->solution_length = -1;
+	this->depths.clear();
+	this->visited_states = 0;
+	this->visited_bytes = 0;
+	this->evictions = 0;
+	this->seconds = 0;
+}
+
+DepthStats* SolverStats::startDepth(int depth) {
+	this->depths.push_back({depth, 0, 0, 0, 0, 0});
+	return &this->depths.back();
+}
+
+
+long SolverStats::getNodesExpanded() const {
+	long total = 0;
+	for (const DepthStats& depth : this->depths) {
+		total += depth.nodes_expanded;
+	}
+	return total;
+}
+
+long SolverStats::getNodesGenerated() const {
+	long total = 0;
+	for (const DepthStats& depth : this->depths) {
+		total += depth.nodes_generated;
+	}
+	return total;
+}
+
+long SolverStats::getDuplicateHits() const {
+	long total = 0;
+	for (const DepthStats& depth : this->depths) {
+		total += depth.duplicate_hits;
+	}
+	return total;
+}
+
+long SolverStats::getNodesPruned() const {
+	long total = 0;
+	for (const DepthStats& depth : this->depths) {
+		total += depth.nodes_pruned;
+	}
+	return total;
+}
+
+double SolverStats::getNodesPerSecond() const {
+	return this->seconds > 0 ? this->getNodesExpanded() / this->seconds : 0;
+}
+
+double SolverStats::getEffectiveBranchingFactor() const {
+	long generated = this->getNodesGenerated();
+	int depth = this->solution_length != -1 ? this->solution_length : (this->depths.empty() ? 0 : this->depths.back().depth);
+	if (generated == 0 || depth <= 0) {
+		return 0;
+	}
+
+	// b + b^2 + ... + b^depth grows with b, so bisect for the b that gives generated
+	double low = 0;
+	double high = generated;
+	for (int i = 0; i < 100; i++) {
+		double b = (low + high) / 2;
+		double tree_size = 0;
+		double level = 1;
+		for (int d = 1; d <= depth && tree_size <= generated; d++) {
+			level *= b;
+			tree_size += level;
+		}
+		if (tree_size < generated) {
+			low = b;
+		} else {
+			high = b;
+		}
+	}
+	return (low + high) / 2;
+}
+
+
+string SolverStats::toJson() const {
+	ostringstream json;
+	json << "{\"algorithm\": \"" << this->algorithm << "\", \"solution_length\": " << this->solution_length
+		<< ", \"seconds\": " << this->seconds
+		<< ", \"nodes_expanded\": " << this->getNodesExpanded()
+		<< ", \"nodes_generated\": " << this->getNodesGenerated()
+		<< ", \"duplicate_hits\": " << this->getDuplicateHits()
+		<< ", \"nodes_pruned\": " << this->getNodesPruned()
+		<< ", \"nodes_per_second\": " << this->getNodesPerSecond()
+		<< ", \"effective_branching_factor\": " << this->getEffectiveBranchingFactor()
+		<< ", \"visited_states\": " << this->visited_states
+		<< ", \"visited_bytes\": " << this->visited_bytes
+		<< ", \"evictions\": " << this->evictions
+		<< ", \"depths\": [";
+	for (size_t i = 0; i < this->depths.size(); i++) {
+		const DepthStats& depth = this->depths[i];
+		json << (i == 0 ? "" : ", ") << "{\"depth\": " << depth.depth
+			<< ", \"nodes_expanded\": " << depth.nodes_expanded
+			<< ", \"nodes_generated\": " << depth.nodes_generated
+			<< ", \"duplicate_hits\": " << depth.duplicate_hits
+			<< ", \"nodes_pruned\": " << depth.nodes_pruned
+			<< ", \"seconds\": " << depth.seconds << "}";
+	}
+	json << "]}";
+	return json.str();
+}
+
+static void writeMetric(ostringstream* text, const string& name, const string& type, const string& help) {
+	*text << "# HELP " << name << " " << help << "\n";
+	*text << "# TYPE " << name << " " << type << "\n";
+}
+
+string SolverStats::toPrometheus(const string& prefix) const {
+	ostringstream text;
+	string labels = "{algorithm=\"" + this->algorithm + "\"}";
+
+	struct { const char* name; const char* type; const char* help; double value; } totals[] = {
+		{"_nodes_expanded_total", "counter", "States whose moves were generated.", (double) this->getNodesExpanded()},
+		{"_nodes_generated_total", "counter", "States produced by moves.", (double) this->getNodesGenerated()},
+		{"_duplicate_hits_total", "counter", "Generated states dropped as already visited.", (double) this->getDuplicateHits()},
+		{"_nodes_pruned_total", "counter", "States cut off by a lower bound.", (double) this->getNodesPruned()},
+		{"_seconds", "gauge", "Wall time of the solve.", this->seconds},
+		{"_nodes_per_second", "gauge", "Expanded states per second.", this->getNodesPerSecond()},
+		{"_effective_branching_factor", "gauge", "Effective branching factor of the search.",
+			this->getEffectiveBranchingFactor()},
+		{"_visited_states", "gauge", "Distinct states in the visited table.", (double) this->visited_states},
+		{"_visited_bytes", "gauge", "Memory held by the visited or transposition table.", (double) this->visited_bytes},
+		{"_evictions_total", "counter", "Table entries lost to other states.", (double) this->evictions},
+		{"_solution_length", "gauge", "Moves in the solution, -1 if none was found.", (double) this->solution_length},
+	};
+	for (const auto& total : totals) {
+		writeMetric(&text, prefix + total.name, total.type, total.help);
+		text << prefix << total.name << labels << " " << total.value << "\n";
+	}
+
+	struct { const char* name; const char* help; long DepthStats::* field; } per_depth[] = {
+		{"_depth_nodes_expanded", "States expanded in each pass.", &DepthStats::nodes_expanded},
+		{"_depth_nodes_generated", "States generated in each pass.", &DepthStats::nodes_generated},
+		{"_depth_duplicate_hits", "Duplicates dropped in each pass.", &DepthStats::duplicate_hits},
+		{"_depth_nodes_pruned", "States pruned in each pass.", &DepthStats::nodes_pruned},
+	};
+	for (const auto& metric : per_depth) {
+		writeMetric(&text, prefix + metric.name, "gauge", metric.help);
+		for (const DepthStats& depth : this->depths) {
+			text << prefix << metric.name << "{algorithm=\"" << this->algorithm << "\",depth=\"" << depth.depth << "\"} "
+				<< depth.*metric.field << "\n";
+		}
+	}
+	writeMetric(&text, prefix + "_depth_seconds", "gauge", "Wall time of each pass.");
+	for (const DepthStats& depth : this->depths) {
+		text << prefix << "_depth_seconds{algorithm=\"" << this->algorithm << "\",depth=\"" << depth.depth << "\"} "
+			<< depth.seconds << "\n";
+	}
+	return text.str();
+}
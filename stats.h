@@ -0,0 +1,56 @@
+#ifndef STATS_H
+#define STATS_H
+
+#include <string>
+#include <vector>
+#include <cstddef>
+
+using namespace std;
+
+// counts for one pass of a search: an iterative deepening depth limit, a bfs layer or an IDA* threshold
+struct DepthStats {
+	int depth; // the depth limit, layer or threshold
+	long nodes_expanded; // states whose moves were generated
+	long nodes_generated; // states produced by those moves
+	long duplicate_hits; // generated states dropped because they had been visited already
+	long nodes_pruned; // states cut off by a lower bound (distance map or transposition table)
+	double seconds;
+};
+
+// what a solve did, filled in by the search when the caller passes one in. counting costs a few increments
+// per node, and nothing at all when no stats are asked for
+struct SolverStats {
+
+	string algorithm;
+	int solution_length; // -1 if not solved
+	vector<DepthStats> depths;
+	long visited_states; // distinct states in the visited table at the end, 0 for IDA*
+	size_t visited_bytes; // memory held by the visited (or transposition) table
+	long evictions; // table entries lost to other states, always 0 for an unbounded table
+	double seconds;
+
+	SolverStats();
+
+	// clears everything and names the algorithm about to run
+	void start(const string& algorithm);
+
+	// appends a zeroed pass at the given depth, valid until the next call
+	DepthStats* startDepth(int depth);
+
+	long getNodesExpanded() const;
+	long getNodesGenerated() const;
+	long getDuplicateHits() const;
+	long getNodesPruned() const;
+	double getNodesPerSecond() const; // expanded nodes per second over the whole solve
+
+	// the b for which a uniform tree of the solution depth (or the deepest pass, if unsolved)
+	// would hold as many generated nodes as the search did. 0 if nothing was generated
+	double getEffectiveBranchingFactor() const;
+
+	string toJson() const;
+
+	// prometheus text exposition format, every metric labelled with the algorithm
+	string toPrometheus(const string& prefix="ricochet_solver") const;
+};
+
+#endif
@@ -0,0 +1,76 @@
+#include "successors.h"
+#include "board.h"
+
+#include <immintrin.h>
+
+using namespace std;
+
+bool SIMD_SUCCESSORS = true;
+
+// per lane constants, repeating every NUM_DIRECTIONS lanes in the order N, S, E, W.
+// north and west slides run toward lower cells, so those lanes are negated and every lane
+// can then take the smallest stop among the blockers
+alignas(32) static const int16_t LANE_SIGNS[NUM_MOVES] = {-1, 1, 1, -1, -1, 1, 1, -1, -1, 1, 1, -1, -1, 1, 1, -1};
+// distance from a blocker back to the cell in front of it, in negated terms for north and west
+alignas(32) static const int16_t LANE_STEPS[NUM_MOVES] = {16, 16, 1, 1, 16, 16, 1, 1, 16, 16, 1, 1, 16, 16, 1, 1};
+// a blocker between start and stop in cell order is on the same line for east and west,
+// north and south also need it in the same column
+alignas(32) static const int16_t LANE_LINE_MASKS[NUM_MOVES] = {15, 15, 0, 0, 15, 15, 0, 0, 15, 15, 0, 0, 15, 15, 0, 0};
+
+
+bool usingSimdSuccessors() {
+	static const bool HAS_AVX2 = __builtin_cpu_supports("avx2");
+	return SIMD_SUCCESSORS && HAS_AVX2;
+}
+
+void slideLanes(const int16_t* starts, int16_t* stops, const int* cells, int num_robots) {
+	if (usingSimdSuccessors()) {
+		slideLanesAvx2(starts, stops, cells, num_robots);
+	} else {
+		slideLanesScalar(starts, stops, cells, num_robots);
+	}
+}
+
+
+void slideLanesScalar(const int16_t* starts, int16_t* stops, const int* cells, int num_robots) {
+	for (int lane = 0; lane < NUM_MOVES; lane++) {
+		int sign = LANE_SIGNS[lane];
+		int start = sign * starts[lane];
+		int lone_stop = sign * stops[lane];
+		int stop = lone_stop;
+		for (int robot = 0; robot < num_robots; robot++) {
+			// the moving robot itself is never strictly past its start, so it needs no masking
+			int blocker = sign * cells[robot];
+			bool same_line = ((cells[robot] ^ starts[lane]) & LANE_LINE_MASKS[lane]) == 0;
+			if (start < blocker && blocker <= lone_stop && same_line) {
+				stop = min(stop, blocker - LANE_STEPS[lane]);
+			}
+		}
+		stops[lane] = sign * stop;
+	}
+}
+
+// the same steps as the scalar kernel, on all sixteen lanes at once
+__attribute__((target("avx2")))
+void slideLanesAvx2(const int16_t* starts, int16_t* stops, const int* cells, int num_robots) {
+	__m256i signs = _mm256_load_si256((const __m256i*) LANE_SIGNS);
+	__m256i steps = _mm256_load_si256((const __m256i*) LANE_STEPS);
+	__m256i line_masks = _mm256_load_si256((const __m256i*) LANE_LINE_MASKS);
+	__m256i zero = _mm256_setzero_si256();
+
+	__m256i raw_starts = _mm256_load_si256((const __m256i*) starts);
+	__m256i start = _mm256_sign_epi16(raw_starts, signs);
+	__m256i lone_stop = _mm256_sign_epi16(_mm256_load_si256((const __m256i*) stops), signs);
+	__m256i stop = lone_stop;
+
+	for (int robot = 0; robot < num_robots; robot++) {
+		__m256i raw_blocker = _mm256_set1_epi16(cells[robot]);
+		__m256i blocker = _mm256_sign_epi16(raw_blocker, signs);
+		__m256i between = _mm256_andnot_si256(_mm256_cmpgt_epi16(blocker, lone_stop), _mm256_cmpgt_epi16(blocker, start));
+		__m256i same_line = _mm256_cmpeq_epi16(_mm256_and_si256(_mm256_xor_si256(raw_blocker, raw_starts), line_masks), zero);
+		__m256i blocked_stop = _mm256_min_epi16(stop, _mm256_sub_epi16(blocker, steps));
+		stop = _mm256_blendv_epi8(stop, blocked_stop, _mm256_and_si256(between, same_line));
+	}
+
+	_mm256_store_si256((__m256i*) stops, _mm256_sign_epi16(stop, signs));
+}
@@ -0,0 +1,26 @@
+#ifndef SUCCESSORS_H
+#define SUCCESSORS_H
+
+#include "robots.h"
+
+#include <cstdint>
+
+using namespace std;
+
+// set false to force the scalar kernel on hosts that have AVX2
+extern bool SIMD_SUCCESSORS;
+
+// true if slideLanes will run the AVX2 kernel
+bool usingSimdSuccessors();
+
+// the slide of every move of one arrangement at once, one 16 bit lane per move in all_moves order
+// (robot * NUM_DIRECTIONS + direction). each lane comes in holding the robot's cell in starts and its
+// lone robot stop (walls only) in stops, and leaves with stops pulled back in front of the nearest of
+// the num_robots robots in cells that sits between the two. only valid for rays without diags.
+// both arrays must be 32 byte aligned. picks the AVX2 kernel when the cpu has it, else the scalar one
+void slideLanes(const int16_t* starts, int16_t* stops, const int* cells, int num_robots);
+
+void slideLanesScalar(const int16_t* starts, int16_t* stops, const int* cells, int num_robots);
+void slideLanesAvx2(const int16_t* starts, int16_t* stops, const int* cells, int num_robots);
+
+#endif
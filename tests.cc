@@ -0,0 +1,590 @@
+#include "board.h"
+#include "solver.h"
+#include "quadrant.h"
+#include "batch.h"
+#include "cache.h"
+#include "external.h"
+#include "optimal.h"
+#include "parallel.h"
+#include "generator.h"
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <set>
+#include <array>
+#include <random>
+#include <cstdlib>
+#include <cstdio>
+#include <dirent.h>
+#include <unistd.h>
+
+using namespace std;
+
+// ricochet-test runs every test below in order, stopping at the first failed ASSERT. make test builds and runs it
+
+// puzzles of every optimal length from 1 to 11, under "# length n" headers
+static const char* TEST_CORPUS = "corpus/pgo_training.txt";
+
+// the external search syncs every layer to disk, so it only gets the shorter puzzles
+static const int MAX_EXTERNAL_TEST_LENGTH = 8;
+
+// arrangements per layout the random move check tries
+static const int NUM_RANDOM_ARRANGEMENTS = 20000;
+
+// searches on uncompiled boards go without distance maps, so only get the shorter puzzles
+static const int MAX_UNCOMPILED_TEST_LENGTH = 6;
+
+// optimal solution counts are checked against enumerating every move list up to this length
+static const int MAX_ENUMERATED_TEST_LENGTH = 5;
+
+// the all targets search is checked on the first few corpus puzzles, against one search per robot and cell
+static const size_t NUM_ALL_TARGETS_TEST_PUZZLES = 4;
+static const int ALL_TARGETS_TEST_DEPTH = 5;
+
+
+// a corpus puzzle with the optimal length from its section header
+struct TestPuzzle {
+	BatchPuzzle puzzle;
+	int solution_length;
+};
+
+static vector<TestPuzzle> readTestCorpus() {
+	ifstream corpus(TEST_CORPUS);
+	ASSERT(corpus, "cannot open " << TEST_CORPUS << ", run the tests from the repo root");
+	vector<TestPuzzle> puzzles;
+	int solution_length = -1;
+	string line;
+	int line_num = 0;
+	while (getline(corpus, line)) {
+		line_num++;
+		if (line.compare(0, 9, "# length ") == 0) {
+			solution_length = atoi(line.c_str() + 9);
+		}
+		if (line.empty() || line[0] == '#') {
+			continue;
+		}
+		TestPuzzle test_puzzle;
+		bool parsed = parseBatchPuzzle(line, line_num, &test_puzzle.puzzle);
+		ASSERT(parsed, TEST_CORPUS << " line " << line_num << ": " << test_puzzle.puzzle.error);
+		test_puzzle.solution_length = solution_length;
+		puzzles.push_back(test_puzzle);
+	}
+	ASSERT(!puzzles.empty(), TEST_CORPUS << " holds no puzzles");
+	return puzzles;
+}
+
+// whether making the moves from the puzzle's start leaves the target robot on the target
+static bool solves(const Board& board, const BatchPuzzle& puzzle, const vector<Move>& moves) {
+	CompactArrangement robot_positions = puzzle.robot_positions;
+	for (Move move : moves) {
+		board.makeMove(move, &robot_positions);
+	}
+	return robot_positions.isSolution(puzzle.dest_cell, puzzle.dest_robot);
+}
+
+// number of move lists of exactly steps_left moves that first reach the target on their last move
+static long countSolutionsByEnumeration(const Board& board, const CompactArrangement& robot_positions,
+	int dest_cell, int dest_robot, int steps_left) {
+
+	if (robot_positions.isSolution(dest_cell, dest_robot)) {
+		return steps_left == 0;
+	}
+	if (steps_left == 0) {
+		return 0;
+	}
+	CompactArrangement children[NUM_MOVES];
+	Move child_moves[NUM_MOVES];
+	int num_children = board.generateChildren(robot_positions, children, child_moves);
+	long total = 0;
+	for (int child = 0; child < num_children; child++) {
+		total += countSolutionsByEnumeration(board, children[child], dest_cell, dest_robot, steps_left - 1);
+	}
+	return total;
+}
+
+static string makeTempDir() {
+	char path[] = "/tmp/ricochet-test-XXXXXX";
+	bool made = mkdtemp(path) != NULL;
+	ASSERT(made, "cannot create a temporary directory");
+	return path;
+}
+
+// the directories the tests make hold plain files only
+static void removeTempDir(const string& path) {
+	DIR* dir = opendir(path.c_str());
+	ASSERT(dir != NULL, "cannot open " << path);
+	for (dirent* entry = readdir(dir); entry != NULL; entry = readdir(dir)) {
+		string name = entry->d_name;
+		if (name != "." && name != "..") {
+			unlink((path + "/" + name).c_str());
+		}
+	}
+	closedir(dir);
+	rmdir(path.c_str());
+}
+
+
+// the board buildBoard lays out, left uncompiled as if it had been built with the setters
+static void buildUncompiledBoard(Board* board, const array<int, 4>& layout) {
+	buildBoard(board, layout[0], layout[1], layout[2], layout[3]);
+	// the board edge already has this barrier, so the walls stay the same and only the compiled tables go
+	board->setRowBarrier(0, 0);
+	ASSERT(!board->isCompiled(), "setting a barrier should drop the compiled tables");
+}
+
+// on random arrangements, the children of a compiled board are the moves the kernel makes on an uncompiled
+// board with the same walls, for layouts with and without diags. a moved robot keeps its above diag bit only on a diag
+static void testRandomMoves() {
+	mt19937 rng(7);
+	const array<int, 4> layouts[] = {{1, 3, 5, 7}, {9, 2, 4, 6}, {8, 9, 9, 1}};
+	for (const array<int, 4>& layout : layouts) {
+		Board board;
+		buildBoard(&board, layout[0], layout[1], layout[2], layout[3]);
+		Board slow_board;
+		buildUncompiledBoard(&slow_board, layout);
+		Bitboard diag_cells = board.getDiagCells();
+
+		for (int i = 0; i < NUM_RANDOM_ARRANGEMENTS; i++) {
+			CompactArrangement robot_positions;
+			bool distinct = true;
+			for (int robot = 0; robot < NUM_ROBOTS; robot++) {
+				int cell = rng() % NUM_CELLS;
+				for (int other = 0; other < robot; other++) {
+					distinct = distinct && robot_positions.getCell(other) != cell;
+				}
+				robot_positions.setRobot(robot, cell, rng() & 1);
+			}
+			if (!distinct) {
+				continue;
+			}
+
+			CompactArrangement children[NUM_MOVES];
+			Move child_moves[NUM_MOVES];
+			int num_children = board.generateChildren(robot_positions, children, child_moves);
+			int child = 0;
+			for (Move move : all_moves) {
+				RobotArrangement slow_positions = robot_positions.toRobotArrangement();
+				bool moved = slow_board.makeMove(move, &slow_positions);
+				bool generated = child < num_children && child_moves[child] == move;
+				ASSERT(moved == generated, "layout " << layout[0] << " " << layout[1] << " " << layout[2] << " "
+					<< layout[3] << ": move " << move << " from " << robot_positions.key() << " disagrees on moving");
+				if (moved) {
+					ASSERT(children[child].key() == encode(slow_positions), "layout " << layout[0] << " " << layout[1]
+						<< " " << layout[2] << " " << layout[3] << ": move " << move << " from " << robot_positions.key()
+						<< " disagrees on the arrangement");
+					int robot = getRobotIndex(move);
+					ASSERT(!children[child].getAboveDiag(robot) || diag_cells.test(children[child].getCell(robot)),
+						"move " << move << " from " << robot_positions.key() << " left an above diag bit off the diags");
+					child++;
+				}
+			}
+		}
+	}
+}
+
+// whether no key of an external search's work_dir shows up in two of its layer files
+static bool layersAreDisjoint(const string& work_dir) {
+	set<uint64_t> seen;
+	for (int depth = 0; ; depth++) {
+		ifstream layer(work_dir + "/layer_" + to_string(depth), ios::binary);
+		if (!layer) {
+			return true;
+		}
+		uint64_t key;
+		while (layer.read((char*) &key, sizeof(key))) {
+			if (!seen.insert(key).second) {
+				return false;
+			}
+		}
+	}
+}
+
+// every engine finds the corpus length, with a move list that solves the puzzle
+static void testEnginesAgree() {
+	// several workers on every layer whatever the machine, so they share the visited set
+	PARALLEL_SEARCH_THREADS = 4;
+	MIN_PARALLEL_LAYER = 1;
+	BoardCache boards;
+	string work_dir = makeTempDir();
+	for (const TestPuzzle& test_puzzle : readTestCorpus()) {
+		const BatchPuzzle& puzzle = test_puzzle.puzzle;
+		shared_ptr<const Board> board_ref = boards.getBoard(puzzle.layout);
+		const Board& board = *board_ref;
+		RobotArrangement robot_positions = puzzle.robot_positions.toRobotArrangement();
+		Position dest(rowOf(puzzle.dest_cell), colOf(puzzle.dest_cell));
+		const string& dest_color = all_colors[puzzle.dest_robot];
+		int expected = test_puzzle.solution_length;
+
+		for (SearchAlgorithm algorithm : {ITERATIVE_DEEPENING, BREADTH_FIRST, IDA_STAR, PARALLEL_BREADTH_FIRST}) {
+			vector<vector<Move>> solutions;
+			int solution_length = solveRicochetBoard(board, robot_positions, dest, dest_color, &solutions, 1, algorithm);
+			ASSERT(solution_length == expected, "line " << puzzle.line_num << ": algorithm " << algorithm
+				<< " found " << solution_length << " moves, expected " << expected);
+			ASSERT(solutions.size() == 1 && (int) solutions[0].size() == expected && solves(board, puzzle, solutions[0]),
+				"line " << puzzle.line_num << ": algorithm " << algorithm << " gave a wrong move list");
+		}
+
+		if (expected <= MAX_EXTERNAL_TEST_LENGTH) {
+			vector<Move> moves;
+			int solution_length = solveRicochetBoardExternal(board, robot_positions, dest, dest_color, &moves,
+				work_dir + "/" + to_string(puzzle.line_num));
+			ASSERT(solution_length == expected && (int) moves.size() == expected && solves(board, puzzle, moves),
+				"line " << puzzle.line_num << ": the external search found " << solution_length << " moves");
+			ASSERT(layersAreDisjoint(work_dir + "/" + to_string(puzzle.line_num)),
+				"line " << puzzle.line_num << ": the external search kept a state in two layers");
+			removeTempDir(work_dir + "/" + to_string(puzzle.line_num));
+		}
+	}
+	removeTempDir(work_dir);
+	PARALLEL_SEARCH_THREADS = 0;
+	MIN_PARALLEL_LAYER = 4096;
+}
+
+// the searches run on boards that were never compiled, without distance maps, helper symmetry or the diag
+// cells of the compiled tables, and find the same lengths
+static void testUncompiledBoards() {
+	for (const TestPuzzle& test_puzzle : readTestCorpus()) {
+		const BatchPuzzle& puzzle = test_puzzle.puzzle;
+		int expected = test_puzzle.solution_length;
+		if (expected > MAX_UNCOMPILED_TEST_LENGTH) {
+			continue;
+		}
+		Board board;
+		buildUncompiledBoard(&board, puzzle.layout);
+		RobotArrangement robot_positions = puzzle.robot_positions.toRobotArrangement();
+		Position dest(rowOf(puzzle.dest_cell), colOf(puzzle.dest_cell));
+		const string& dest_color = all_colors[puzzle.dest_robot];
+
+		for (SearchAlgorithm algorithm : {ITERATIVE_DEEPENING, BREADTH_FIRST, IDA_STAR, PARALLEL_BREADTH_FIRST}) {
+			vector<vector<Move>> solutions;
+			int solution_length = solveRicochetBoard(board, robot_positions, dest, dest_color, &solutions, 1, algorithm);
+			ASSERT(solution_length == expected && solutions.size() == 1 && solves(board, puzzle, solutions[0]),
+				"line " << puzzle.line_num << ": algorithm " << algorithm << " found " << solution_length
+				<< " moves on an uncompiled board, expected " << expected);
+		}
+		OptimalSolutionDag dag;
+		int solution_length = solveAllOptimal(board, robot_positions, dest, dest_color, &dag);
+		ASSERT(solution_length == expected, "line " << puzzle.line_num << ": the dag found " << solution_length
+			<< " moves on an uncompiled board, expected " << expected);
+		ASSERT(!board.isCompiled(), "a search compiled the board");
+	}
+}
+
+// slides robot in direction from the neighbor of cell behind it, with the other robots on the cell's other neighbors
+// to stop it there. returns whether it stops on cell, leaving its above diag bit in above_diag
+static bool slideOnto(const Board& board, int cell, int direction, int robot, bool* above_diag) {
+	const int row_steps[NUM_DIRECTIONS] = {-1, 1, 0, 0};
+	const int col_steps[NUM_DIRECTIONS] = {0, 0, 1, -1};
+	int from_row = rowOf(cell) - row_steps[direction];
+	int from_col = colOf(cell) - col_steps[direction];
+	if (from_row < 0 || from_row >= COMPILED_DIMENSION || from_col < 0 || from_col >= COMPILED_DIMENSION) {
+		return false;
+	}
+	Bitboard used;
+	used.set(cell);
+	used.set(cellOf(from_row, from_col));
+	vector<int> blockers;
+	for (int side = 0; side < NUM_DIRECTIONS; side++) {
+		int row = rowOf(cell) + row_steps[side];
+		int col = colOf(cell) + col_steps[side];
+		if (row >= 0 && row < COMPILED_DIMENSION && col >= 0 && col < COMPILED_DIMENSION && !used.test(cellOf(row, col))) {
+			blockers.push_back(cellOf(row, col));
+			used.set(cellOf(row, col));
+		}
+	}
+	// robots left over go anywhere out of the way
+	for (int other = 0; (int) blockers.size() < NUM_ROBOTS - 1; other++) {
+		if (!used.test(other)) {
+			blockers.push_back(other);
+		}
+	}
+
+	CompactArrangement robot_positions;
+	robot_positions.setRobot(robot, cellOf(from_row, from_col), false);
+	for (int other = 0, blocker = 0; other < NUM_ROBOTS; other++) {
+		if (other != robot) {
+			robot_positions.setRobot(other, blockers[blocker++], false);
+		}
+	}
+	board.makeMove(direction * NUM_ROBOTS + robot, &robot_positions);
+	*above_diag = robot_positions.getAboveDiag(robot);
+	return robot_positions.getCell(robot) == cell;
+}
+
+// generated puzzles with a robot starting on a diag cell put it on a side of the diag a move leaves it on,
+// keep that side through the batch format, and solve to the same length on every engine
+static void testGeneratedDiagStarts() {
+	mt19937 rng(11);
+	int num_diag_starts = 0;
+	bool seen_sides[2] = {false, false};
+	for (int i = 0; i < 5000 && num_diag_starts < 24; i++) {
+		BatchPuzzle puzzle;
+		generatePuzzle(&rng, &puzzle);
+		Board board;
+		buildBoard(&board, puzzle.layout[0], puzzle.layout[1], puzzle.layout[2], puzzle.layout[3]);
+		Bitboard diag_cells = board.getDiagCells();
+		bool on_diag = false;
+		for (int robot = 0; robot < NUM_ROBOTS; robot++) {
+			int cell = puzzle.robot_positions.getCell(robot);
+			if (!diag_cells.test(cell)) {
+				continue;
+			}
+			on_diag = true;
+			seen_sides[puzzle.robot_positions.getAboveDiag(robot)] = true;
+			bool arrives = false;
+			for (int direction = 0; direction < NUM_DIRECTIONS; direction++) {
+				bool above_diag;
+				bool moved_onto = slideOnto(board, cell, direction, robot, &above_diag);
+				bool side_above_diag;
+				bool has_side = board.arrivalSide(cell, direction, robot, &side_above_diag);
+				ASSERT(!has_side || (moved_onto && side_above_diag == above_diag), "\""
+					<< formatBatchPuzzle(puzzle) << "\": the arrival side of robot " << robot << " in direction "
+					<< direction << " is not where a move leaves it");
+				arrives = arrives || (has_side && above_diag == puzzle.robot_positions.getAboveDiag(robot));
+			}
+			ASSERT(arrives, "\"" << formatBatchPuzzle(puzzle) << "\" puts robot " << robot
+				<< " on a side of its diag that no move leaves it on");
+		}
+		if (!on_diag) {
+			continue;
+		}
+		num_diag_starts++;
+
+		BatchPuzzle reparsed;
+		bool parsed = parseBatchPuzzle(formatBatchPuzzle(puzzle), 1, &reparsed);
+		ASSERT(parsed && reparsed.robot_positions.key() == puzzle.robot_positions.key(),
+			"\"" << formatBatchPuzzle(puzzle) << "\" does not read back with its diag sides");
+
+		// only the shorter ones are solved, the rest must be out of reach on every engine alike
+		RobotArrangement robot_positions = puzzle.robot_positions.toRobotArrangement();
+		Position dest(rowOf(puzzle.dest_cell), colOf(puzzle.dest_cell));
+		const string& dest_color = all_colors[puzzle.dest_robot];
+		Board slow_board;
+		buildUncompiledBoard(&slow_board, puzzle.layout);
+		vector<vector<Move>> solutions;
+		int expected = solveRicochetBoard(board, robot_positions, dest, dest_color, &solutions, 1, BREADTH_FIRST, 8);
+		ASSERT(expected < 0 || solves(board, puzzle, solutions[0]), "\"" << formatBatchPuzzle(puzzle)
+			<< "\" got a wrong move list");
+		for (SearchAlgorithm algorithm : {ITERATIVE_DEEPENING, IDA_STAR}) {
+			for (const Board* engine_board : {(const Board*) &board, (const Board*) &slow_board}) {
+				int solution_length = solveRicochetBoard(*engine_board, robot_positions, dest, dest_color, &solutions,
+					1, algorithm, 8);
+				ASSERT(solution_length == expected, "\"" << formatBatchPuzzle(puzzle) << "\": algorithm " << algorithm
+					<< " found " << solution_length << " moves, expected " << expected);
+			}
+		}
+	}
+	ASSERT(num_diag_starts == 24 && seen_sides[false] && seen_sides[true],
+		"the generator put too few robots on diag cells, or all on one side");
+}
+
+// every robot and cell from one all targets search, against a breadth first search for that target alone
+static void testAllTargets() {
+	vector<TestPuzzle> test_puzzles = readTestCorpus();
+	for (size_t i = 0; i < test_puzzles.size() && i < NUM_ALL_TARGETS_TEST_PUZZLES; i++) {
+		BatchPuzzle puzzle = test_puzzles[i].puzzle;
+		Board board;
+		buildBoard(&board, puzzle.layout[0], puzzle.layout[1], puzzle.layout[2], puzzle.layout[3]);
+		RobotArrangement robot_positions = puzzle.robot_positions.toRobotArrangement();
+		AllTargetsSolution all_targets;
+		solveAllTargets(board, robot_positions, &all_targets, ALL_TARGETS_TEST_DEPTH);
+
+		int num_solved = 0;
+		for (int robot = 0; robot < NUM_ROBOTS; robot++) {
+			for (int cell = 0; cell < NUM_CELLS; cell++) {
+				Position dest(rowOf(cell), colOf(cell));
+				vector<Move> moves;
+				int solution_length = all_targets.getSolution(dest, all_colors[robot], &moves);
+				num_solved += solution_length != -1;
+				if (cell == puzzle.robot_positions.getCell(robot)) {
+					ASSERT(solution_length == 0, "a robot is not 0 moves from its own cell");
+					continue;
+				}
+				vector<vector<Move>> solutions;
+				int expected = solveRicochetBoard(board, robot_positions, dest, all_colors[robot], &solutions, 1,
+					BREADTH_FIRST, ALL_TARGETS_TEST_DEPTH);
+				puzzle.dest_cell = cell;
+				puzzle.dest_robot = robot;
+				ASSERT(solution_length == expected && (solution_length == -1 || solves(board, puzzle, moves)),
+					"line " << puzzle.line_num << ": all targets found " << solution_length << " moves for "
+					<< all_colors[robot] << " to " << rowOf(cell) << " " << colOf(cell) << ", expected " << expected);
+			}
+		}
+		ASSERT(num_solved == all_targets.numSolved(), "numSolved counts " << all_targets.numSolved()
+			<< " targets, " << num_solved << " have solutions");
+	}
+}
+
+// the checks of testOptimalSolutions on one puzzle of known length
+static void checkOptimalSolutions(const Board& board, const BatchPuzzle& puzzle, int expected) {
+	OptimalSolutionDag dag;
+	int solution_length = solveAllOptimal(board, puzzle.robot_positions.toRobotArrangement(),
+		Position(rowOf(puzzle.dest_cell), colOf(puzzle.dest_cell)), all_colors[puzzle.dest_robot], &dag);
+	ASSERT(solution_length == expected, "line " << puzzle.line_num << ": the dag found " << solution_length
+		<< " moves, expected " << expected);
+
+	set<vector<Move>> listed;
+	dag.forEachSolution([&](const vector<Move>& moves) {
+		ASSERT((int) moves.size() == solution_length && solves(board, puzzle, moves),
+			"line " << puzzle.line_num << ": the dag listed a wrong move list");
+		listed.insert(moves);
+		return true;
+	});
+	ASSERT(listed.size() == dag.countSolutions(), "line " << puzzle.line_num << ": the dag counts "
+		<< dag.countSolutions() << " solutions but lists " << listed.size());
+
+	if (solution_length <= MAX_ENUMERATED_TEST_LENGTH) {
+		long enumerated = countSolutionsByEnumeration(board, puzzle.robot_positions, puzzle.dest_cell,
+			puzzle.dest_robot, solution_length);
+		ASSERT(enumerated == (long) dag.countSolutions(), "line " << puzzle.line_num << ": the dag counts "
+			<< dag.countSolutions() << " solutions, enumerating finds " << enumerated);
+	}
+}
+
+// the dag has the corpus length, lists as many distinct solutions as it counts, and on short puzzles
+// counts as many as trying every move list does
+static void testOptimalSolutions() {
+	BoardCache boards;
+	for (const TestPuzzle& test_puzzle : readTestCorpus()) {
+		checkOptimalSolutions(*boards.getBoard(test_puzzle.puzzle.layout), test_puzzle.puzzle,
+			test_puzzle.solution_length);
+	}
+
+	// on a diag layout, green,south and green,west lead two solutions through one state, reached with a different
+	// above diag bit left on green. both only count once the bit is cleared off the diags
+	BatchPuzzle puzzle;
+	bool parsed = parseBatchPuzzle("3 4 9 8  14 14 0 9 13 2 10 8  4 0 green", 0, &puzzle);
+	ASSERT(parsed, "bad diag test puzzle: " << puzzle.error);
+	checkOptimalSolutions(*boards.getBoard(puzzle.layout), puzzle, 4);
+}
+
+// results survive reopening the file, and a search that found nothing only answers up to its depth
+// a bounded board cache drops the least recently used board, which lives on while a caller holds it
+static void testBoardCache() {
+	BoardCache boards(2);
+	const array<int, 4> first = {1, 3, 5, 7};
+	const array<int, 4> second = {2, 4, 6, 8};
+	const array<int, 4> third = {9, 2, 4, 6};
+	shared_ptr<const Board> first_board = boards.getBoard(first);
+	shared_ptr<const Board> second_board = boards.getBoard(second);
+	ASSERT(boards.getBoard(first) == first_board, "a cached board was built again");
+	shared_ptr<const Board> third_board = boards.getBoard(third);
+	ASSERT(boards.getBoard(first) == first_board, "the most recently used board was dropped");
+	ASSERT(second_board->isCompiled() && boards.getBoard(second) != second_board,
+		"the least recently used board was kept");
+	ASSERT(third_board->getFingerprint() != first_board->getFingerprint(), "two layouts gave one board");
+}
+
+static void testSolutionCache() {
+	string dir = makeTempDir();
+	string path = dir + "/cache";
+	CacheKey solved_key = {1, 2, 3, 0};
+	CacheKey unsolved_key = {1, 2, 4, 1};
+	vector<Move> moves = {RED_NORTH, BLUE_WEST, RED_EAST};
+	{
+		SolutionCache cache(path);
+		ASSERT(cache.isOpen(), "cannot open a new cache at " << path);
+		int solution_length;
+		bool hit = cache.lookup(solved_key, 20, &solution_length, NULL);
+		ASSERT(!hit, "an empty cache hit");
+		bool stored = cache.store(solved_key, 20, moves.size(), moves);
+		stored = cache.store(unsolved_key, 6, -1, vector<Move>()) && stored;
+		ASSERT(stored && cache.size() == 2, "the cache holds " << cache.size() << " puzzles, expected 2");
+	}
+
+	SolutionCache cache(path, true);
+	ASSERT(cache.isOpen() && cache.size() == 2, "a reopened cache lost its records");
+	bool stored = cache.store(solved_key, 30, moves.size(), moves);
+	ASSERT(!stored && cache.size() == 2, "a read only cache took a record");
+	int solution_length;
+	vector<Move> cached_moves;
+	bool hit = cache.lookup(solved_key, 20, &solution_length, &cached_moves);
+	ASSERT(hit && solution_length == 3 && cached_moves == moves, "a stored solution came back wrong");
+	hit = cache.lookup(solved_key, 3, &solution_length, &cached_moves);
+	ASSERT(hit && solution_length == -1, "a solution as long as max_depth should read as none");
+	hit = cache.lookup(unsolved_key, 5, &solution_length, NULL);
+	ASSERT(hit && solution_length == -1, "a search to depth 6 answers depth 5");
+	hit = cache.lookup(unsolved_key, 7, &solution_length, NULL);
+	ASSERT(!hit, "a search to depth 6 cannot answer depth 7");
+	ASSERT(cache.getHits() == 3 && cache.getMisses() == 1, "hits and misses miscounted");
+
+	unlink(path.c_str());
+	removeTempDir(dir);
+}
+
+// well formed lines read back through formatBatchPuzzle, malformed ones are turned away with a reason
+static void testBatchParser() {
+	BatchPuzzle puzzle;
+	bool parsed = parseBatchPuzzle("1 4 5 8  0 9 5 11 7 3 9 8  11 15 green", 7, &puzzle);
+	ASSERT(parsed && puzzle.line_num == 7 && puzzle.error.empty(), "a good line did not parse: " << puzzle.error);
+	ASSERT(puzzle.layout[0] == 1 && puzzle.layout[3] == 8, "layout parsed wrong");
+	ASSERT(puzzle.robot_positions.getCell(1) == cellOf(5, 11) && puzzle.dest_cell == cellOf(11, 15) &&
+		puzzle.dest_robot == getRobotIndex("green"), "positions parsed wrong");
+	BatchPuzzle reparsed;
+	parsed = parseBatchPuzzle(formatBatchPuzzle(puzzle), 7, &reparsed);
+	ASSERT(parsed && reparsed.robot_positions.key() == puzzle.robot_positions.key() &&
+		reparsed.dest_cell == puzzle.dest_cell && reparsed.dest_robot == puzzle.dest_robot &&
+		reparsed.layout == puzzle.layout, "a formatted puzzle does not read back");
+
+	const pair<string, string> malformed[] = {
+		{"0 4 5 8  0 9 5 11 7 3 9 8  11 15 green", "bad quadrant layout"},
+		{"1 4 5 8  0 9 5 11 7 3 9", "bad blue robot position"},
+		{"1 4 5 8  0 9 5 16 7 3 9 8  11 15 green", "bad red robot position"},
+		{"1 4 5 8  0 9 0 9 7 3 9 8  11 15 green", "two robots on one cell"},
+		{"1 4 5 8  0 9 5 11 7 3 9 8  11 green", "bad target position"},
+		{"1 4 5 8  0 9 5 11 7 3 9 8  11 15 purple", "bad target color"},
+		{"1 4 5 8  0 9 5 11 7 3 9 8  11 15 green 1", "trailing fields"},
+	};
+	for (const pair<string, string>& line : malformed) {
+		parsed = parseBatchPuzzle(line.first, 1, &puzzle);
+		ASSERT(!parsed && puzzle.error == line.second, "\"" << line.first << "\" gave \"" << puzzle.error
+			<< "\", expected \"" << line.second << "\"");
+	}
+
+	// results come back in input order, errors included, through a cache that answers the repeat
+	string dir = makeTempDir();
+	string path = dir + "/cache";
+	SolutionCache cache(path);
+	istringstream in("# comment\n1 4 5 8 0 9 5 11 7 3 9 8 11 15 green\n\nnot a puzzle\n"
+		"1 4 5 8 0 9 5 11 7 3 9 8 11 15 green\n");
+	ostringstream out;
+	int num_errors = solveBatch(in, out, 2, ITERATIVE_DEEPENING, DEFAULT_MAX_DEPTH, &cache);
+	ASSERT(num_errors == 1 && cache.getHits() + cache.getMisses() == 2, "the batch miscounted its puzzles");
+	istringstream results(out.str());
+	string line;
+	vector<string> result_lines;
+	while (getline(results, line)) {
+		result_lines.push_back(line);
+	}
+	ASSERT(result_lines.size() == 3 && result_lines[0].compare(0, 4, "2 3 ") == 0 &&
+		result_lines[1] == "4 error bad quadrant layout" && result_lines[2].compare(0, 4, "5 3 ") == 0,
+		"unexpected batch output\n" << out.str());
+	unlink(path.c_str());
+	removeTempDir(dir);
+}
+
+
+int main() {
+	const pair<string, void (*)()> tests[] = {
+		{"testEastMove", testEastMove},
+		{"testWestMove", testWestMove},
+		{"testNortMove", testNortMove},
+		{"testSouthMove", testSouthMove},
+		{"testCompiledMoves", testCompiledMoves},
+		{"testRandomMoves", testRandomMoves},
+		{"testBatchParser", testBatchParser},
+		{"testBoardCache", testBoardCache},
+		{"testSolutionCache", testSolutionCache},
+		{"testEnginesAgree", testEnginesAgree},
+		{"testUncompiledBoards", testUncompiledBoards},
+		{"testGeneratedDiagStarts", testGeneratedDiagStarts},
+		{"testAllTargets", testAllTargets},
+		{"testOptimalSolutions", testOptimalSolutions},
+	};
+	for (const pair<string, void (*)()>& test : tests) {
+		test.second();
+		cout << test.first << " passed" << endl;
+	}
+	return 0;
+}
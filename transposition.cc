@@ -0,0 +1,140 @@
+#include "transposition.h"
+
+#include <iostream>
+#include <algorithm>
+#include <climits>
+
+using namespace std;
+
+size_t DEFAULT_TABLE_ENTRIES = size_t(1) << 22;
+const int BOUNDED_BUCKET_ENTRIES = 4;
+
+
+TranspositionTable::TranspositionTable(size_t num_entries) {
+	ASSERT(num_entries > 0, "a transposition table needs at least one entry");
+	size_t capacity = 1;
+	while (capacity * 2 <= num_entries) {
+		capacity *= 2;
+	}
+	this->entries.assign(capacity, 0);
+	this->mask = capacity - 1;
+	this->evictions = 0;
+}
+
+size_t TranspositionTable::slot(RobotArrangementEncoding key) const {
+	// fibonacci hashing, the low bits of the key are mostly the above diag bits
+	return ((uint64_t(key) * 0x9E3779B97F4A7C15ULL) >> 20) & this->mask;
+}
+
+int TranspositionTable::getLowerBound(const CompactArrangement& robot_positions) const {
+	uint64_t entry = this->entries[this->slot(robot_positions.key())];
+	return (entry >> 8) == robot_positions.key() ? entry & 0xff : 0;
+}
+
+void TranspositionTable::setLowerBound(const CompactArrangement& robot_positions, int lower_bound) {
+	DEBUG_ASSERT(lower_bound >= 0, "lower bounds cannot be negative");
+	uint64_t key = robot_positions.key();
+	uint64_t& entry = this->entries[this->slot(key)];
+	if ((entry >> 8) == key && int(entry & 0xff) >= lower_bound) {
+		return;
+	}
+	this->evictions += entry != 0 && (entry >> 8) != key;
+	entry = (key << 8) | min(lower_bound, 0xff);
+}
+
+size_t TranspositionTable::capacity() const {
+	return this->entries.size();
+}
+
+size_t TranspositionTable::bytes() const {
+	return this->entries.size() * sizeof(uint64_t);
+}
+
+long TranspositionTable::getEvictions() const {
+	return this->evictions;
+}
+
+
+
+BoundedVisitedTable::BoundedVisitedTable(size_t max_bytes) {
+	size_t bucket_bytes = BOUNDED_BUCKET_ENTRIES * sizeof(uint64_t);
+	ASSERT(max_bytes >= bucket_bytes, "a bounded visited table needs at least " << bucket_bytes << " bytes");
+	size_t num_buckets = 1;
+	while (num_buckets * 2 * bucket_bytes <= max_bytes) {
+		num_buckets *= 2;
+	}
+	this->entries.assign(num_buckets * BOUNDED_BUCKET_ENTRIES, 0);
+	this->mask = num_buckets - 1;
+	this->generation = 0;
+	this->num_states = 0;
+	this->evictions = 0;
+}
+
+size_t BoundedVisitedTable::bucket(RobotArrangementEncoding key) const {
+	return (((uint64_t(key) * 0x9E3779B97F4A7C15ULL) >> 20) & this->mask) * BOUNDED_BUCKET_ENTRIES;
+}
+
+bool BoundedVisitedTable::raiseStepsLeft(const CompactArrangement& robot_positions, int steps_left) {
+	DEBUG_ASSERT(steps_left >= 0, "cannot record negative steps left");
+	uint64_t key = robot_positions.key();
+	uint64_t* bucket = &this->entries[this->bucket(key)];
+	uint64_t new_entry = (key << 16) | (uint64_t(this->generation) << 8) | min(steps_left + 1, 0xff);
+
+	// the weakest entry is the one to give up if the arrangement is not in the bucket yet
+	int victim = 0;
+	int victim_rank = INT_MAX;
+	for (int i = 0; i < BOUNDED_BUCKET_ENTRIES; i++) {
+		uint64_t entry = bucket[i];
+		int recorded_steps = int(entry & 0xff) - 1;
+		if (recorded_steps >= 0 && (entry >> 16) == key) {
+			if (recorded_steps >= steps_left) {
+				// still in use, so it counts as part of this pass
+				bucket[i] = (entry & ~uint64_t(0xff00)) | (uint64_t(this->generation) << 8);
+				return false;
+			}
+			bucket[i] = new_entry;
+			return true;
+		}
+
+		bool current = int((entry >> 8) & 0xff) == this->generation;
+		int rank = recorded_steps < 0 ? -1 : (current ? 0x100 : 0) | recorded_steps;
+		if (rank < victim_rank) {
+			victim = i;
+			victim_rank = rank;
+		}
+	}
+
+	if (victim_rank < 0) {
+		this->num_states++;
+	} else if (victim_rank >= 0x100 && (victim_rank & 0xff) > steps_left) {
+		this->evictions++;
+		return true;
+	} else {
+		this->evictions++;
+	}
+	bucket[victim] = new_entry;
+	return true;
+}
+
+void BoundedVisitedTable::prefetch(const CompactArrangement* robot_positions, int num_arrangements) const {
+	for (int i = 0; i < num_arrangements; i++) {
+		__builtin_prefetch(&this->entries[this->bucket(robot_positions[i].key())], 1);
+	}
+}
+
+void BoundedVisitedTable::newGeneration() {
+	// wraps after 256 passes, an entry that old just looks current again, which is harmless
+	this->generation = (this->generation + 1) & 0xff;
+}
+
+long BoundedVisitedTable::size() const {
+	return this->num_states;
+}
+
+size_t BoundedVisitedTable::bytes() const {
+	return this->entries.size() * sizeof(uint64_t);
+}
+
+long BoundedVisitedTable::getEvictions() const {
+	return this->evictions;
+}
@@ -0,0 +1,83 @@
+#ifndef TRANSPOSITION_H
+#define TRANSPOSITION_H
+
+#include "robots.h"
+
+#include <vector>
+
+using namespace std;
+
+// entries in a TranspositionTable unless asked otherwise, 32 MB
+extern size_t DEFAULT_TABLE_ENTRIES;
+
+// entries per bucket of a BoundedVisitedTable, 32 bytes
+extern const int BOUNDED_BUCKET_ENTRIES;
+
+// fixed size table of proven lower bounds on the moves left to a solution, per packed arrangement.
+// each entry is one word holding the key and its bound. the table never grows,
+// a new bound simply overwrites whatever shared its slot, which only loses pruning, never solutions
+class TranspositionTable {
+
+	vector<uint64_t> entries; // key << 8 | bound, 0 is empty
+	uint64_t mask;
+	long evictions;
+
+	size_t slot(RobotArrangementEncoding key) const;
+
+public:
+
+	// num_entries is rounded down to a power of two
+	TranspositionTable(size_t num_entries=DEFAULT_TABLE_ENTRIES);
+
+	// best lower bound recorded for this arrangement, 0 if none
+	int getLowerBound(const CompactArrangement& robot_positions) const;
+	void setLowerBound(const CompactArrangement& robot_positions, int lower_bound);
+
+	size_t capacity() const;
+	size_t bytes() const;
+
+	// bounds overwritten by a different arrangement sharing their slot
+	long getEvictions() const;
+};
+
+
+// the steps left at each visit of an iterative deepening search, like VisitedTable, but in a fixed budget
+// of memory. slots are grouped in buckets of BOUNDED_BUCKET_ENTRIES that share a hash, and a full bucket
+// gives up the entry of an older pass first, then the one with the fewest steps left. a new arrangement
+// with fewer steps left than everything of the current pass in its bucket is not stored at all.
+// a lost entry only means the arrangement may be expanded again, never a missed solution.
+// every entry carries the pass it was last touched in, so passes never clear the table
+class BoundedVisitedTable {
+
+	vector<uint64_t> entries; // key << 16 | generation << 8 | steps left + 1, 0 is empty
+	uint64_t mask; // over buckets
+	int generation;
+	long num_states;
+	long evictions;
+
+	size_t bucket(RobotArrangementEncoding key) const;
+
+public:
+
+	// the largest power of two number of buckets that fits in max_bytes
+	BoundedVisitedTable(size_t max_bytes);
+
+	// same contract as VisitedTable::raiseStepsLeft, except that the record may be lost later
+	bool raiseStepsLeft(const CompactArrangement& robot_positions, int steps_left);
+
+	void prefetch(const CompactArrangement* robot_positions, int num_arrangements) const;
+
+	// starts a new pass, whose entries win over those of every earlier pass
+	void newGeneration();
+
+	// number of arrangements currently recorded
+	long size() const;
+
+	// always the whole table, it is allocated up front
+	size_t bytes() const;
+
+	// records pushed out of a full bucket, or turned away by one
+	long getEvictions() const;
+};
+
+#endif
@@ -0,0 +1,205 @@
+#include "visited.h"
+
+#include <iostream>
+#include <sys/mman.h>
+#include <unistd.h>
+
+using namespace std;
+
+int MAX_RECORDED_STEPS = 14;
+
+// one nibble for every combination of four cells
+static const size_t DENSE_BYTES = (size_t(1) << 32) / 2;
+
+
+VisitedTable::VisitedTable(const Board& board, bool huge_pages) {
+	this->diag_cells = board.getDiagCells();
+	this->num_states = 0;
+	this->num_bytes = DENSE_BYTES;
+
+	// pages are only backed once touched, so the table costs what the search actually visits
+	void* mapping = mmap(NULL, this->num_bytes, PROT_READ | PROT_WRITE,
+		MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+	if (mapping == MAP_FAILED) {
+		// every arrangement goes to the side map instead
+		this->nibbles = NULL;
+		this->num_bytes = 0;
+		return;
+	}
+
+	this->nibbles = (uint8_t*) mapping;
+	if (huge_pages) {
+		madvise(mapping, this->num_bytes, MADV_HUGEPAGE);
+	}
+}
+
+VisitedTable::~VisitedTable() {
+	if (this->nibbles != NULL) {
+		munmap(this->nibbles, this->num_bytes);
+	}
+}
+
+
+bool VisitedTable::onDiag(const CompactArrangement& robot_positions) const {
+	for (int robot = 0; robot < NUM_ROBOTS; robot++) {
+		if (this->diag_cells.test(robot_positions.getCell(robot))) {
+			return true;
+		}
+	}
+	return false;
+}
+
+int VisitedTable::load(const CompactArrangement& robot_positions) const {
+	if (this->nibbles == NULL || this->onDiag(robot_positions)) {
+		auto entry = this->on_diag.find(robot_positions.key());
+		return entry == this->on_diag.end() ? 0 : entry->second;
+	}
+
+	uint32_t index = robot_positions.key() >> 4;
+	return (this->nibbles[index >> 1] >> (4 * (index & 1))) & 0xf;
+}
+
+void VisitedTable::store(const CompactArrangement& robot_positions, int value) {
+	if (this->nibbles == NULL || this->onDiag(robot_positions)) {
+		this->on_diag[robot_positions.key()] = value;
+		return;
+	}
+
+	uint32_t index = robot_positions.key() >> 4;
+	uint8_t* byte = &this->nibbles[index >> 1];
+	int shift = 4 * (index & 1);
+	*byte = (*byte & ~(0xf << shift)) | (value << shift);
+}
+
+
+int VisitedTable::getStepsLeft(const CompactArrangement& robot_positions) const {
+	return this->load(robot_positions) - 1;
+}
+
+void VisitedTable::setStepsLeft(const CompactArrangement& robot_positions, int steps_left) {
+	DEBUG_ASSERT(steps_left >= 0, "cannot record negative steps left");
+	if (this->load(robot_positions) == 0) {
+		this->num_states++;
+	}
+	// recording fewer steps than there were only costs a re-expansion later, never a missed solution
+	this->store(robot_positions, min(steps_left, MAX_RECORDED_STEPS) + 1);
+}
+
+bool VisitedTable::raiseStepsLeft(const CompactArrangement& robot_positions, int steps_left) {
+	DEBUG_ASSERT(steps_left >= 0, "cannot record negative steps left");
+	int value = min(steps_left, MAX_RECORDED_STEPS) + 1;
+
+	if (this->nibbles == NULL || this->onDiag(robot_positions)) {
+		uint8_t& entry = this->on_diag[robot_positions.key()];
+		if (entry - 1 >= steps_left) {
+			return false;
+		}
+		this->num_states += entry == 0;
+		entry = value;
+		return true;
+	}
+
+	// single read modify write of the nibble, this is the hot path of the iterative deepening
+	uint32_t index = robot_positions.key() >> 4;
+	uint8_t* byte = &this->nibbles[index >> 1];
+	int shift = 4 * (index & 1);
+	int prev_value = (*byte >> shift) & 0xf;
+	if (prev_value - 1 >= steps_left) {
+		return false;
+	}
+	this->num_states += prev_value == 0;
+	*byte = (*byte & ~(0xf << shift)) | (value << shift);
+	return true;
+}
+
+bool VisitedTable::insert(const CompactArrangement& robot_positions) {
+	return this->raiseStepsLeft(robot_positions, 0);
+}
+
+void VisitedTable::prefetch(const CompactArrangement* robot_positions, int num_arrangements) const {
+	if (this->nibbles == NULL) {
+		return;
+	}
+	for (int i = 0; i < num_arrangements; i++) {
+		uint32_t index = robot_positions[i].key() >> 4;
+		__builtin_prefetch(&this->nibbles[index >> 1], 1);
+	}
+}
+
+long VisitedTable::size() const {
+	return this->num_states;
+}
+
+size_t VisitedTable::bytes() const {
+	// a side map entry is a hash node (next pointer, key, value) plus its bucket pointer
+	size_t total = this->on_diag.size() * (sizeof(void*) + sizeof(pair<RobotArrangementEncoding, uint8_t>)) +
+		this->on_diag.bucket_count() * sizeof(void*);
+	if (this->nibbles == NULL) {
+		return total;
+	}
+
+	size_t page_size = sysconf(_SC_PAGESIZE);
+	vector<unsigned char> resident((this->num_bytes + page_size - 1) / page_size);
+	if (mincore(this->nibbles, this->num_bytes, resident.data()) != 0) {
+		return total;
+	}
+	for (unsigned char page : resident) {
+		total += (page & 1) * page_size;
+	}
+	return total;
+}
+
+void VisitedTable::clear() {
+	if (this->nibbles != NULL) {
+		// hands the touched pages back, they read as zero again on the next touch
+		madvise(this->nibbles, this->num_bytes, MADV_DONTNEED);
+	}
+	this->on_diag.clear();
+	this->num_states = 0;
+}
+
+
+
+// one bit for every combination of four cells
+static const size_t DENSE_BITS_BYTES = (size_t(1) << 32) / 8;
+
+
+AtomicVisitedSet::AtomicVisitedSet(const Board& board) {
+	this->diag_cells = board.getDiagCells();
+	this->num_bytes = DENSE_BITS_BYTES;
+
+	void* mapping = mmap(NULL, this->num_bytes, PROT_READ | PROT_WRITE,
+		MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+	if (mapping == MAP_FAILED) {
+		this->words = NULL;
+		this->num_bytes = 0;
+		return;
+	}
+	this->words = (uint64_t*) mapping;
+}
+
+AtomicVisitedSet::~AtomicVisitedSet() {
+	if (this->words != NULL) {
+		munmap(this->words, this->num_bytes);
+	}
+}
+
+bool AtomicVisitedSet::insert(const CompactArrangement& robot_positions) {
+	bool on_diag = this->words == NULL;
+	for (int robot = 0; robot < NUM_ROBOTS && !on_diag; robot++) {
+		on_diag = this->diag_cells.test(robot_positions.getCell(robot));
+	}
+
+	if (on_diag) {
+		lock_guard<mutex> lock(this->on_diag_mutex);
+		return this->on_diag.insert(robot_positions.key()).second;
+	}
+
+	uint32_t index = robot_positions.key() >> 4;
+	uint64_t bit = uint64_t(1) << (index & 63);
+	uint64_t* word = &this->words[index >> 6];
+	if (__atomic_load_n(word, __ATOMIC_RELAXED) & bit) {
+		return false;
+	}
+	return (__atomic_fetch_or(word, bit, __ATOMIC_RELAXED) & bit) == 0;
+}
@@ -0,0 +1,89 @@
+#ifndef VISITED_H
+#define VISITED_H
+
+#include "robots.h"
+#include "board.h"
+
+#include <unordered_map>
+#include <unordered_set>
+#include <mutex>
+
+using namespace std;
+
+// largest steps left a VisitedTable can hold, anything above is recorded as this
+extern int MAX_RECORDED_STEPS;
+
+// dense record of the arrangements a search has visited, with how many steps were left at the visit.
+// arrangements where no robot sits on a diag cell are indexed directly by their 32 bits of cells,
+// one nibble each, in a lazily mapped table, which huge_pages (off by default) asks the kernel to back
+// with transparent huge pages.
+// off diag cells the above diag bit never affects a later move, so it can be left out of the index.
+// the rare arrangements with a robot on a diag cell go to a small side map keyed by the full key
+class VisitedTable {
+
+	uint8_t* nibbles; // two states per byte, 0 is unseen, otherwise steps left + 1. NULL if the mapping failed
+	size_t num_bytes;
+	Bitboard diag_cells;
+	unordered_map<RobotArrangementEncoding, uint8_t> on_diag; // same values as the nibbles
+	long num_states;
+
+	bool onDiag(const CompactArrangement& robot_positions) const;
+	int load(const CompactArrangement& robot_positions) const;
+	void store(const CompactArrangement& robot_positions, int value);
+
+public:
+
+	VisitedTable(const Board& board, bool huge_pages=false);
+	~VisitedTable();
+	VisitedTable(const VisitedTable&) = delete;
+	VisitedTable& operator=(const VisitedTable&) = delete;
+
+	// steps left recorded for this arrangement, -1 if it was never visited
+	int getStepsLeft(const CompactArrangement& robot_positions) const;
+	void setStepsLeft(const CompactArrangement& robot_positions, int steps_left);
+
+	// records steps_left and returns true if the arrangement was never visited with that many steps left.
+	// equivalent to comparing getStepsLeft and then calling setStepsLeft, in one probe
+	bool raiseStepsLeft(const CompactArrangement& robot_positions, int steps_left);
+
+	// marks the arrangement visited, returns true if it had not been visited before
+	bool insert(const CompactArrangement& robot_positions);
+
+	// starts pulling the entries for a batch of arrangements into cache, ahead of probing them
+	void prefetch(const CompactArrangement* robot_positions, int num_arrangements) const;
+
+	// number of distinct arrangements recorded
+	long size() const;
+
+	// memory actually held: the resident pages of the dense table plus an estimate of the side map.
+	// walks the page table, so it is for reporting, not for calling per node
+	size_t bytes() const;
+
+	// forgets every arrangement
+	void clear();
+};
+
+
+// visited set shared by several threads, one bit per arrangement, indexed like VisitedTable.
+// marking is a single atomic or on the bit's word, so threads never wait on each other
+// except for the rare arrangements with a robot on a diag cell, which go through a locked side set
+class AtomicVisitedSet {
+
+	uint64_t* words; // NULL if the mapping failed
+	size_t num_bytes;
+	Bitboard diag_cells;
+	mutex on_diag_mutex;
+	unordered_set<RobotArrangementEncoding> on_diag;
+
+public:
+
+	AtomicVisitedSet(const Board& board);
+	~AtomicVisitedSet();
+	AtomicVisitedSet(const AtomicVisitedSet&) = delete;
+	AtomicVisitedSet& operator=(const AtomicVisitedSet&) = delete;
+
+	// marks the arrangement visited, returns true for exactly one of the threads inserting it
+	bool insert(const CompactArrangement& robot_positions);
+};
+
+#endif